@@ -1,9 +1,305 @@
+#define _DEFAULT_SOURCE
+
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "array.h"
+
+/**
+ * Size of a huge page (2MB). Arrays at least this large are backed by huge
+ * pages when the huge page mode allows it.
+ */
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/**
+ * Alignment of every row, in bytes. One cache line, which also covers the
+ * widest SIMD registers (AVX-512).
+ */
+#define ROW_ALIGNMENT 64
+
+/**
+ * Row strides (in bytes) that are a multiple of this map every row onto the
+ * same L1 cache sets, so the rows above and below in the stencil evict each
+ * other. Strides like this are padded by one extra cache line.
+ */
+#define CACHE_SET_ALIASING_STRIDE 4096
+
+#define ALLOCATION_MALLOC 0
+#define ALLOCATION_MMAP 1
+
+/**
+ * Bookkeeping stored directly before the row pointers of each array, so that
+ * the free functions know how the block of elements was allocated.
+ */
+typedef struct {
+    void *block;
+    size_t bytes;
+    int allocation;
+} ArrayHeader;
+
+static int hugePageMode = HUGE_PAGES_TRANSPARENT;
+
+/**
+ * Set how arrays created after this call should be backed by huge pages.
+ *
+ * @param mode HUGE_PAGES_NONE, HUGE_PAGES_TRANSPARENT or HUGE_PAGES_EXPLICIT
+ */
+void setHugePageMode(const int mode)
+{
+    hugePageMode = mode;
+}
+
+/**
+ * Round input up to the next multiple of the given multiple.
+ *
+ * @param  input    Value to round
+ * @param  multiple Value that returned value should be divisible by
+ *
+ * @return          Smallest value >= input that is divisible by multiple
+ */
+static size_t roundUp(const size_t input, const size_t multiple)
+{
+    return ((input + multiple - 1) / multiple) * multiple;
+}
+
+/**
+ * Get the number of bytes between the start of consecutive rows of an array
+ * with the given number of columns of the given size.
+ *
+ * Rows are padded to a whole number of cache lines, plus one more cache line
+ * if that would leave the stride a multiple of CACHE_SET_ALIASING_STRIDE
+ * (e.g. when cols is a large power of two).
+ *
+ * @param  cols        Number of columns in the array
+ * @param  elementSize Size of each element, in bytes
+ *
+ * @return             Row stride, in bytes
+ */
+static size_t rowStrideBytes(const int cols, const size_t elementSize)
+{
+    size_t strideBytes = roundUp(cols * elementSize, ROW_ALIGNMENT);
+
+    if (strideBytes % CACHE_SET_ALIASING_STRIDE == 0) {
+        strideBytes += ROW_ALIGNMENT;
+    }
+
+    return strideBytes;
+}
+
+/**
+ * Get the number of doubles between the start of consecutive rows of an array
+ * created by createTwoDDoubleArray with the given number of columns.
+ *
+ * @param  cols Number of columns in the array
+ *
+ * @return      Row stride, in doubles
+ */
+int twoDDoubleArrayRowStride(const int cols)
+{
+    return rowStrideBytes(cols, sizeof(double)) / sizeof(double);
+}
+
+/**
+ * Get the number of floats between the start of consecutive rows of an array
+ * created by createTwoDFloatArray with the given number of columns.
+ *
+ * @param  cols Number of columns in the array
+ *
+ * @return      Row stride, in floats
+ */
+int twoDFloatArrayRowStride(const int cols)
+{
+    return rowStrideBytes(cols, sizeof(float)) / sizeof(float);
+}
+
+/**
+ * Allocate a block of memory of at least the given size, aligned to at least
+ * ROW_ALIGNMENT, and backed by huge pages if the huge page mode allows.
+ *
+ * Explicit huge pages need pages reserved by the system administrator, so if
+ * they cannot be mapped this falls back to transparent huge pages.
+ *
+ * @param  bytes  Number of bytes to allocate
+ * @param  header Header to record the allocation in
+ *
+ * @return        0 if success, -1 otherwise
+ */
+static int allocateBlock(const size_t bytes, ArrayHeader * const header)
+{
+    if (hugePageMode != HUGE_PAGES_NONE && bytes >= HUGE_PAGE_SIZE) {
+        const size_t mappedBytes = roundUp(bytes, HUGE_PAGE_SIZE);
+        void *block = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+        if (hugePageMode == HUGE_PAGES_EXPLICIT) {
+            block = mmap(
+                NULL,
+                mappedBytes,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                -1,
+                0
+            );
+        }
+#endif
+
+        if (block == MAP_FAILED) {
+            block = mmap(
+                NULL,
+                mappedBytes,
+                PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS,
+                -1,
+                0
+            );
+
+#ifdef MADV_HUGEPAGE
+            if (block != MAP_FAILED) {
+                // Only a hint, so ignore failure (e.g. THP disabled)
+                madvise(block, mappedBytes, MADV_HUGEPAGE);
+            }
+#endif
+        }
+
+        if (block != MAP_FAILED) {
+            header->block = block;
+            header->bytes = mappedBytes;
+            header->allocation = ALLOCATION_MMAP;
+
+            return 0;
+        }
+    }
+
+    void *block;
+
+    if (posix_memalign(&block, ROW_ALIGNMENT, bytes)) {
+        return -1;
+    }
+
+    header->block = block;
+    header->bytes = bytes;
+    header->allocation = ALLOCATION_MALLOC;
+
+    return 0;
+}
+
+/**
+ * Allocate the header, row pointers and zeroed block of elements of a two
+ * dimensional array. The row pointers directly follow the returned header,
+ * and are left for the caller to fill in.
+ *
+ * Every element (including padding) is zeroed here. This is the first touch
+ * of the memory, so pages are placed on the NUMA node of the calling process,
+ * which is the process that will go on to relax the rows.
+ *
+ * @param  rows        Number of rows in the array
+ * @param  strideBytes Bytes between the start of each row
+ * @param  pointerSize Size of each row pointer, in bytes
+ *
+ * @return             Pointer to the header, or NULL if memory could not be
+ *                     allocated
+ */
+static ArrayHeader *createArray(
+    const int rows,
+    const size_t strideBytes,
+    const size_t pointerSize
+)
+{
+    ArrayHeader * const header = (ArrayHeader *)malloc(
+        sizeof(ArrayHeader) + rows * pointerSize
+    );
+
+    if (!header) {
+        return NULL;
+    }
+
+    if (allocateBlock((size_t)rows * strideBytes, header)) {
+        free(header);
+
+        return NULL;
+    }
+
+    memset(header->block, 0, (size_t)rows * strideBytes);
+
+    return header;
+}
+
+/**
+ * Frees a given two dimensional array created with createArray.
+ *
+ * @param array  The row pointers of the array to free
+ */
+static void freeArray(void * const array)
+{
+    ArrayHeader * const header = ((ArrayHeader *)array) - 1;
+
+    if (header->allocation == ALLOCATION_MMAP) {
+        munmap(header->block, header->bytes);
+    } else {
+        free(header->block);
+    }
+
+    free(header);
+}
 
 /**
- * Create a square two dimensional array of doubles of the dimensions
- * specified. Creates these in a specific way so that all doubles are
- * contiguous in memory.
+ * Create a one dimensional array of doubles of the size specified, aligned
+ * to a cache line and backed by huge pages in the same way as the two
+ * dimensional arrays. The header recording the allocation is kept in the
+ * first cache line of the block, directly before the returned doubles.
+ *
+ * All doubles are initially 0.0.
+ *
+ * Note: freeOneDDoubleArray should always be called on the returned array to
+ * clean up memory.
+ *
+ * @param  size Number of doubles in array to be created
+ *
+ * @return      Pointer to the created array, or NULL if memory could not be
+ *              allocated
+ */
+double *createOneDDoubleArray(const size_t size)
+{
+    ArrayHeader header;
+
+    if (allocateBlock(ROW_ALIGNMENT + size * sizeof(double), &header)) {
+        return NULL;
+    }
+
+    memset(header.block, 0, ROW_ALIGNMENT + size * sizeof(double));
+    memcpy(header.block, &header, sizeof(ArrayHeader));
+
+    return (double *)((char *)header.block + ROW_ALIGNMENT);
+}
+
+/**
+ * Frees a given one dimensional array of doubles. Partners the above
+ * createOneDDoubleArray function.
+ *
+ * @param array  The one dimensional array of doubles to free
+ */
+void freeOneDDoubleArray(double * const array)
+{
+    ArrayHeader header;
+
+    memcpy(&header, (char *)array - ROW_ALIGNMENT, sizeof(ArrayHeader));
+
+    if (header.allocation == ALLOCATION_MMAP) {
+        munmap(header.block, header.bytes);
+    } else {
+        free(header.block);
+    }
+}
+
+/**
+ * Create a two dimensional array of doubles of the dimensions specified.
+ * Creates these in a specific way so that all doubles are in one block of
+ * memory, with each row starting on a cache line boundary. Rows are padded
+ * to twoDDoubleArrayRowStride(cols) doubles, so consecutive rows are only
+ * contiguous in memory if cols is already a multiple of the stride.
+ *
+ * All doubles are initially 0.0.
  *
  * Note: freeTwoDDoubleArray should always be called on the returned array to
  * clean up memory.
@@ -11,16 +307,29 @@
  * @param  rows      Number of rows in double array to be created
  * @param  cols      Number of columns in double array to be created
  *
- * @return           Pointer to the created two dimensional array
+ * @return           Pointer to the created two dimensional array, or NULL if
+ *                   memory could not be allocated
  */
 double **createTwoDDoubleArray(const int rows, const int cols)
 {
-    double *doubles = (double *)malloc(rows * cols * sizeof(double));
+    const int stride = twoDDoubleArrayRowStride(cols);
 
-    double **createdRows = (double **)malloc(rows * sizeof(double*));
+    ArrayHeader * const header = createArray(
+        rows,
+        stride * sizeof(double),
+        sizeof(double*)
+    );
+
+    if (!header) {
+        return NULL;
+    }
+
+    double * const doubles = (double *)header->block;
+
+    double **createdRows = (double **)(header + 1);
 
     for (int row = 0; row < rows; row++) {
-        createdRows[row] = &(doubles[row * cols]);
+        createdRows[row] = &(doubles[(size_t)row * stride]);
     }
 
     return createdRows;
@@ -34,7 +343,56 @@ double **createTwoDDoubleArray(const int rows, const int cols)
  */
 void freeTwoDDoubleArray(double **array)
 {
-    free(&(array[0][0]));
+    freeArray(array);
+}
 
-    free(array);
+/**
+ * Create a two dimensional array of floats of the dimensions specified, laid
+ * out in the same way as by createTwoDDoubleArray.
+ *
+ * All floats are initially 0.0.
+ *
+ * Note: freeTwoDFloatArray should always be called on the returned array to
+ * clean up memory.
+ *
+ * @param  rows      Number of rows in float array to be created
+ * @param  cols      Number of columns in float array to be created
+ *
+ * @return           Pointer to the created two dimensional array, or NULL if
+ *                   memory could not be allocated
+ */
+float **createTwoDFloatArray(const int rows, const int cols)
+{
+    const int stride = twoDFloatArrayRowStride(cols);
+
+    ArrayHeader * const header = createArray(
+        rows,
+        stride * sizeof(float),
+        sizeof(float*)
+    );
+
+    if (!header) {
+        return NULL;
+    }
+
+    float * const floats = (float *)header->block;
+
+    float **createdRows = (float **)(header + 1);
+
+    for (int row = 0; row < rows; row++) {
+        createdRows[row] = &(floats[(size_t)row * stride]);
+    }
+
+    return createdRows;
+}
+
+/**
+ * Frees a given two dimensional array of floats. Partners the above
+ * createTwoDFloatArray function.
+ *
+ * @param array  The two dimensional array of floats to free
+ */
+void freeTwoDFloatArray(float **array)
+{
+    freeArray(array);
 }
@@ -1,10 +1,69 @@
+#include <stddef.h>
+
+/**
+ * Huge page modes for setHugePageMode.
+ *
+ * HUGE_PAGES_NONE        Never use huge pages
+ * HUGE_PAGES_TRANSPARENT Ask the kernel for transparent huge pages (default)
+ * HUGE_PAGES_EXPLICIT    Use reserved (hugetlbfs) huge pages, falling back to
+ *                        transparent huge pages if none are available
+ */
+#define HUGE_PAGES_NONE 0
+#define HUGE_PAGES_TRANSPARENT 1
+#define HUGE_PAGES_EXPLICIT 2
+
+/**
+ * Set how arrays created after this call should be backed by huge pages.
+ *
+ * @param mode HUGE_PAGES_NONE, HUGE_PAGES_TRANSPARENT or HUGE_PAGES_EXPLICIT
+ */
+void setHugePageMode(const int mode);
+
+/**
+ * Get the number of doubles between the start of consecutive rows of an array
+ * created by createTwoDDoubleArray.
+ *
+ * @param  cols Number of columns in the array
+ *
+ * @return      Row stride, in doubles
+ */
+int twoDDoubleArrayRowStride(const int cols);
+
+/**
+ * Get the number of floats between the start of consecutive rows of an array
+ * created by createTwoDFloatArray.
+ *
+ * @param  cols Number of columns in the array
+ *
+ * @return      Row stride, in floats
+ */
+int twoDFloatArrayRowStride(const int cols);
+
 /**
- * Create a square two dimensional array of doubles of the dimensions specified.
+ * Create a one dimensional array of doubles of the size specified.
+ *
+ * @param  size Number of doubles in array to be created
+ *
+ * @return      Pointer to the created array, or NULL if memory could not be
+ *              allocated
+ */
+double *createOneDDoubleArray(const size_t size);
+
+/**
+ * Frees a given one dimensional array of doubles.
+ *
+ * @param array     The one dimensional array to free
+ */
+void freeOneDDoubleArray(double * const array);
+
+/**
+ * Create a two dimensional array of doubles of the dimensions specified.
  *
  * @param  rows      Number of rows in double array to be created
  * @param  cols      Number of columns in double array to be created
  *
- * @return           Pointer to the created two dimensional array
+ * @return           Pointer to the created two dimensional array, or NULL if
+ *                   memory could not be allocated
  */
 double **createTwoDDoubleArray(const int rows, const int cols);
 
@@ -12,6 +71,23 @@ double **createTwoDDoubleArray(const int rows, const int cols);
  * Frees a given two dimensional array of doubles.
  *
  * @param array     The two dimensional array to free
- * @param dimension The dimension of the two dimensional array to free
  */
 void freeTwoDDoubleArray(double **array);
+
+/**
+ * Create a two dimensional array of floats of the dimensions specified.
+ *
+ * @param  rows      Number of rows in float array to be created
+ * @param  cols      Number of columns in float array to be created
+ *
+ * @return           Pointer to the created two dimensional array, or NULL if
+ *                   memory could not be allocated
+ */
+float **createTwoDFloatArray(const int rows, const int cols);
+
+/**
+ * Frees a given two dimensional array of floats.
+ *
+ * @param array     The two dimensional array to free
+ */
+void freeTwoDFloatArray(float **array);
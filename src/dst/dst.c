@@ -0,0 +1,283 @@
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "dst.h"
+
+#define PI 3.14159265358979323846
+
+/**
+ * Everything needed to take discrete sine transforms of one length.
+ *
+ * A DST-I of length n is computed from an FFT of length 2(n + 1) of the odd
+ * extension of the input. When that FFT length is not a power of two it is
+ * computed with Bluestein's algorithm, as a convolution of power of two
+ * length.
+ */
+struct DstPlan {
+    int length;
+    int fftLength;
+
+    // Power of two length of the FFTs actually taken
+    int radix2Length;
+
+    // roots[k] = exp(-2 pi i k / radix2Length), for k < radix2Length / 2
+    double complex *roots;
+
+    // Bluestein only (NULL otherwise)
+    double complex *chirp;
+    double complex *chirpFft;
+
+    double complex *work;
+};
+
+/**
+ * In place radix-2 FFT.
+ *
+ * @param data    Array of length n to transform
+ * @param n       Length of data (a power of two)
+ * @param roots   Roots of unity of the plan
+ * @param rootsOf Length the roots were generated for (a multiple of n)
+ * @param inverse 1 to take the (unscaled) inverse transform, 0 otherwise
+ */
+static void fft(
+    double complex * const data,
+    const int n,
+    const double complex * const roots,
+    const int rootsOf,
+    const int inverse
+)
+{
+    // Bit reversal permutation
+    for (int i = 1, j = 0; i < n; i++) {
+        int bit = n >> 1;
+
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+
+        j ^= bit;
+
+        if (i < j) {
+            const double complex swap = data[i];
+            data[i] = data[j];
+            data[j] = swap;
+        }
+    }
+
+    for (int length = 2; length <= n; length <<= 1) {
+        const int half = length >> 1;
+        const int rootStep = rootsOf / length;
+
+        for (int start = 0; start < n; start += length) {
+            for (int k = 0; k < half; k++) {
+                const double complex root = inverse
+                    ? conj(roots[k * rootStep])
+                    : roots[k * rootStep];
+
+                const double complex even = data[start + k];
+                const double complex odd = data[start + k + half] * root;
+
+                data[start + k] = even + odd;
+                data[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+/**
+ * Checks if the given value is a power of two.
+ *
+ * @param  n Value to check (> 0)
+ *
+ * @return   1 if a power of two, 0 otherwise
+ */
+static int isPowerOfTwo(const int n)
+{
+    return (n & (n - 1)) == 0;
+}
+
+/**
+ * Create a plan for taking discrete sine transforms (DST-I) of the given
+ * length.
+ *
+ * Note: freeDstPlan should always be called on the returned plan to clean up
+ * memory.
+ *
+ * @param  length Length of the transforms
+ *
+ * @return        Pointer to the created plan, NULL if it could not be created
+ */
+DstPlan *createDstPlan(const int length)
+{
+    DstPlan * const plan = (DstPlan *)calloc(1, sizeof(DstPlan));
+
+    if (!plan) {
+        return NULL;
+    }
+
+    plan->length = length;
+    plan->fftLength = 2 * (length + 1);
+
+    const int bluestein = !isPowerOfTwo(plan->fftLength);
+
+    // Bluestein needs a convolution of at least 2 * fftLength - 1
+    plan->radix2Length = 1;
+
+    while (plan->radix2Length < (bluestein ? 2 * plan->fftLength - 1
+                                           : plan->fftLength)) {
+        plan->radix2Length <<= 1;
+    }
+
+    const int n = plan->radix2Length;
+
+    plan->roots = (double complex *)malloc((n / 2) * sizeof(double complex));
+    plan->work = (double complex *)malloc(n * sizeof(double complex));
+
+    if (!plan->roots || !plan->work) {
+        freeDstPlan(plan);
+
+        return NULL;
+    }
+
+    for (int k = 0; k < n / 2; k++) {
+        plan->roots[k] = cexp(-2.0 * PI * I * k / n);
+    }
+
+    if (!bluestein) {
+        return plan;
+    }
+
+    const int m = plan->fftLength;
+
+    plan->chirp = (double complex *)malloc(m * sizeof(double complex));
+    plan->chirpFft = (double complex *)calloc(n, sizeof(double complex));
+
+    if (!plan->chirp || !plan->chirpFft) {
+        freeDstPlan(plan);
+
+        return NULL;
+    }
+
+    for (int k = 0; k < m; k++) {
+        // k^2 mod 2m keeps the angle small, so it stays accurate for large k
+        const long long square = ((long long)k * k) % (2 * m);
+
+        plan->chirp[k] = cexp(-PI * I * square / m);
+    }
+
+    plan->chirpFft[0] = conj(plan->chirp[0]);
+
+    for (int k = 1; k < m; k++) {
+        plan->chirpFft[k] = conj(plan->chirp[k]);
+        plan->chirpFft[n - k] = conj(plan->chirp[k]);
+    }
+
+    fft(plan->chirpFft, n, plan->roots, n, 0);
+
+    return plan;
+}
+
+/**
+ * Take the FFT (of length plan->fftLength) of the values in plan->work.
+ *
+ * @param plan Plan to take the FFT with
+ */
+static void planFft(DstPlan * const plan)
+{
+    const int n = plan->radix2Length;
+
+    if (!plan->chirp) {
+        fft(plan->work, n, plan->roots, n, 0);
+
+        return;
+    }
+
+    const int m = plan->fftLength;
+    double complex * const work = plan->work;
+
+    for (int k = 0; k < m; k++) {
+        work[k] *= plan->chirp[k];
+    }
+
+    for (int k = m; k < n; k++) {
+        work[k] = 0;
+    }
+
+    // Convolve with the conjugate chirp
+    fft(work, n, plan->roots, n, 0);
+
+    for (int k = 0; k < n; k++) {
+        work[k] *= plan->chirpFft[k];
+    }
+
+    fft(work, n, plan->roots, n, 1);
+
+    for (int k = 0; k < m; k++) {
+        work[k] *= plan->chirp[k] / n;
+    }
+}
+
+/**
+ * Take the discrete sine transform (DST-I) of two arrays of values in place:
+ *
+ *     X[k] = sum over j of x[j] sin(pi (j + 1) (k + 1) / (length + 1))
+ *
+ * Applying it twice scales the input by (length + 1) / 2.
+ *
+ * The FFT of the odd extension of real values is purely imaginary, so two
+ * arrays are transformed with one FFT: one as the real part, and one as the
+ * imaginary part, which ends up in the real part of the result.
+ *
+ * @param plan    Plan for the length of values
+ * @param values  Values to transform
+ * @param values2 More values to transform (may be NULL)
+ */
+void dstPair(
+    DstPlan * const plan,
+    double * const values,
+    double * const values2
+)
+{
+    const int length = plan->length;
+    double complex * const work = plan->work;
+
+    // Odd extension: 0, x, 0, -reversed x
+    work[0] = 0;
+    work[length + 1] = 0;
+
+    for (int j = 0; j < length; j++) {
+        const double complex value = values2
+            ? values[j] + I * values2[j]
+            : values[j];
+
+        work[j + 1] = value;
+        work[plan->fftLength - 1 - j] = -value;
+    }
+
+    planFft(plan);
+
+    for (int k = 0; k < length; k++) {
+        values[k] = -cimag(work[k + 1]) / 2;
+    }
+
+    if (values2) {
+        for (int k = 0; k < length; k++) {
+            values2[k] = creal(work[k + 1]) / 2;
+        }
+    }
+}
+
+/**
+ * Frees a given DST plan. Partners the above createDstPlan function.
+ *
+ * @param plan The plan to free
+ */
+void freeDstPlan(DstPlan * const plan)
+{
+    free(plan->roots);
+    free(plan->chirp);
+    free(plan->chirpFft);
+    free(plan->work);
+    free(plan);
+}
@@ -0,0 +1,36 @@
+/**
+ * Everything needed to take discrete sine transforms of one length.
+ */
+typedef struct DstPlan DstPlan;
+
+/**
+ * Create a plan for taking discrete sine transforms (DST-I) of the given
+ * length.
+ *
+ * @param  length Length of the transforms
+ *
+ * @return        Pointer to the created plan, NULL if it could not be created
+ */
+DstPlan *createDstPlan(const int length);
+
+/**
+ * Take the discrete sine transform (DST-I) of two arrays of values in place,
+ * with the cost of one. Applying it twice scales the input by
+ * (length + 1) / 2.
+ *
+ * @param plan    Plan for the length of values
+ * @param values  Values to transform
+ * @param values2 More values to transform (may be NULL)
+ */
+void dstPair(
+    DstPlan * const plan,
+    double * const values,
+    double * const values2
+);
+
+/**
+ * Frees a given DST plan.
+ *
+ * @param plan The plan to free
+ */
+void freeDstPlan(DstPlan * const plan);
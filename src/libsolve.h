@@ -0,0 +1,32 @@
+/**
+ * Public header for the solve library (bin/libsolve.a, bin/libsolve.so).
+ *
+ * Typical use, solving a sequence of related problems:
+ *
+ *     SolveContext *context = createSolveContext(n, processors, comm);
+ *
+ *     if (solveContextRunning(context)) {
+ *         double **problem = solveContextProblem(context);
+ *
+ *         // Fill problem, then for each step:
+ *         //   update the edges of problem,
+ *         //   solveWithContext(context, precision, 1, 0, NULL),
+ *         //   read the solution from problem.
+ *     }
+ *
+ *     freeSolveContext(context);
+ *
+ * The solution of each step is left in the problem array, so the next step
+ * starts from it.
+ *
+ * Only the solve context and snapshotter functions are exported; every other
+ * symbol of the library is internal to it. Grids of 2MB or more are always
+ * backed by transparent huge pages where the system supports them.
+ */
+#ifndef LIBSOLVE_H
+#define LIBSOLVE_H
+
+#include "snapshot/snapshot.h"
+#include "solve/solve.h"
+
+#endif
@@ -5,13 +5,33 @@
 
 #include "array/array.h"
 #include "problem/problem.h"
+#include "snapshot/snapshot.h"
 #include "solve/solve.h"
 #include "test/test.h"
+#include "tune/tune.h"
 
 #define HELP "Argument order:\n"\
              " - Problem dimension (integer > 0).\n"\
              " - Precision to work to (number > 0).\n"\
-             " - Optional: [--test|-t] to test achieved solution.\n"
+             " - Optional: [--test|-t] to test achieved solution.\n"\
+             " - Optional: --huge-pages=[none|transparent|explicit] to choose\n"\
+             "   how grids are backed by huge pages (default transparent).\n"\
+             " - Optional: --snapshot=[file] to write snapshots of the solution\n"\
+             "   to a file or named pipe while solving. Configure with:\n"\
+             "   --snapshot-every=[iterations] (default 100)\n"\
+             "   --snapshot-mode=[full|downsample|stats] (default full)\n"\
+             "   --snapshot-downsample=[n] write every nth row/column in\n"\
+             "   downsample mode (default 10)\n"\
+             " - Optional: --check-every=[iterations] to only check for\n"\
+             "   convergence every so many iterations (default 1).\n"\
+             " - Optional: --solver=[iterative|dst] to solve by relaxation\n"\
+             "   (default), or directly with discrete sine transforms.\n"\
+             " - Optional: [--mixed-precision|-m] to solve by defect\n"\
+             "   correction, with sweeps in single precision.\n"\
+             " - Optional: --reference to print the largest difference\n"\
+             "   between the iterative solution and the direct solution.\n"\
+             " - Optional: [--autotune|-a] to choose the number of processors\n"\
+             "   and check interval automatically (overrides --check-every).\n"
 
 #define INVALID_NUM_ARGS "You must specify problem dimension and precision.\n"
 
@@ -21,8 +41,32 @@
 #define INVALID_PRECISION "Invalid precision given. "\
                           "Must be a number greater than 0\n"
 
+#define INVALID_HUGE_PAGES "Invalid huge page mode given. "\
+                           "Must be none, transparent or explicit.\n"
+
+#define INVALID_SNAPSHOT "Invalid snapshot options given. Interval and "\
+                         "downsample must be integers greater than 0, and "\
+                         "mode must be full, downsample or stats.\n"
+
+#define SNAPSHOT_ERROR "Could not start snapshot writer.\n"
+
+#define INVALID_CHECK_INTERVAL "Invalid check interval given. "\
+                               "Must be an integer greater than 0.\n"
+
+#define INVALID_SOLVER "Invalid solver given. "\
+                       "Must be iterative or dst.\n"
+
+#define INVALID_DST_OPTIONS "The dst solver does not iterate, so cannot be "\
+                            "used with --mixed-precision, --check-every, "\
+                            "--snapshot or --reference.\n"
+
+#define REFERENCE_DIFFERENCE "Largest difference from direct solution: %g\n"
+
 #define ERROR "Something went wrong. Error code: %d\n"
 
+#define SOLVER_ITERATIVE 0
+#define SOLVER_DST 1
+
 #define MPI_ERROR "Something went wrong with MPI. Error code: %d\n"
 
 /**
@@ -80,24 +124,189 @@ static int testFlagSet(int argc, char *argv[])
 }
 
 /**
- * Round input to the first value greater than input that is divisble by given
- * multiple.
+ * Checks if any of the parameters passed via CLI are --autotune or -a.
+ *
+ * @param  argc Number of command line argmuments
+ * @param  argv Array of command line arguments
+ *
+ * @return      1 if true (autotune flag specified), 0 otherwise
+ */
+static int autotuneFlagSet(int argc, char *argv[])
+{
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--autotune") == 0
+            || strcmp(argv[i], "-a") == 0) {
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Checks if any of the parameters passed via CLI are --mixed-precision or -m.
+ *
+ * @param  argc Number of command line argmuments
+ * @param  argv Array of command line arguments
+ *
+ * @return      1 if true (mixed precision flag specified), 0 otherwise
+ */
+static int mixedPrecisionFlagSet(int argc, char *argv[])
+{
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--mixed-precision") == 0
+            || strcmp(argv[i], "-m") == 0) {
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Checks if any of the parameters passed via CLI are --reference.
+ *
+ * @param  argc Number of command line argmuments
+ * @param  argv Array of command line arguments
+ *
+ * @return      1 if true (reference flag specified), 0 otherwise
+ */
+static int referenceFlagSet(int argc, char *argv[])
+{
+    for (int i = 0; i < argc; i++) {
+        if (strcmp(argv[i], "--reference") == 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Finds the value of a parameter passed via CLI in the form --name=value.
+ *
+ * @param  argc Number of command line argmuments
+ * @param  argv Array of command line arguments
+ * @param  name Name of the parameter, including leading dashes and trailing =
+ *
+ * @return      Pointer to the value if given, NULL otherwise
+ */
+static const char *flagValue(int argc, char *argv[], const char * const name)
+{
+    const size_t nameLength = strlen(name);
+
+    for (int i = 0; i < argc; i++) {
+        if (strncmp(argv[i], name, nameLength) == 0) {
+            return argv[i] + nameLength;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Parses the huge page mode passed via CLI as --huge-pages=mode.
+ *
+ * @param  argc Number of command line argmuments
+ * @param  argv Array of command line arguments
+ *
+ * @return      The HUGE_PAGES_* mode (HUGE_PAGES_TRANSPARENT if not given),
+ *              -1 if an invalid mode was given
+ */
+static int parseHugePageMode(int argc, char *argv[])
+{
+    const char * const value = flagValue(argc, argv, "--huge-pages=");
+
+    if (!value || strcmp(value, "transparent") == 0) {
+        return HUGE_PAGES_TRANSPARENT;
+    }
+
+    if (strcmp(value, "none") == 0) {
+        return HUGE_PAGES_NONE;
+    }
+
+    if (strcmp(value, "explicit") == 0) {
+        return HUGE_PAGES_EXPLICIT;
+    }
+
+    return -1;
+}
+
+/**
+ * Parses the solver passed via CLI as --solver=solver.
  *
- * @param  input    Value to round
- * @param  multiple Value that returned value should be divisible by
+ * @param  argc Number of command line argmuments
+ * @param  argv Array of command line arguments
  *
- * @return          First value greater than input that is divisible by given
- *                  multiple
+ * @return      The SOLVER_* solver (SOLVER_ITERATIVE if not given), -1 if an
+ *              invalid solver was given
  */
-static int roundToMultiple(const int input, const int multiple)
+static int parseSolver(int argc, char *argv[])
 {
-    const int remainder = input % multiple;
+    const char * const value = flagValue(argc, argv, "--solver=");
+
+    if (!value || strcmp(value, "iterative") == 0) {
+        return SOLVER_ITERATIVE;
+    }
 
-    if (!remainder) {
-        return input;
+    if (strcmp(value, "dst") == 0) {
+        return SOLVER_DST;
     }
 
-    return input + multiple - remainder;
+    return -1;
+}
+
+/**
+ * Parses the snapshot mode passed via CLI as --snapshot-mode=mode.
+ *
+ * @param  argc Number of command line argmuments
+ * @param  argv Array of command line arguments
+ *
+ * @return      The SNAPSHOT_* mode (SNAPSHOT_FULL if not given), -1 if an
+ *              invalid mode was given
+ */
+static int parseSnapshotMode(int argc, char *argv[])
+{
+    const char * const value = flagValue(argc, argv, "--snapshot-mode=");
+
+    if (!value || strcmp(value, "full") == 0) {
+        return SNAPSHOT_FULL;
+    }
+
+    if (strcmp(value, "downsample") == 0) {
+        return SNAPSHOT_DOWNSAMPLED;
+    }
+
+    if (strcmp(value, "stats") == 0) {
+        return SNAPSHOT_STATS;
+    }
+
+    return -1;
+}
+
+/**
+ * Parses an integer parameter passed via CLI as --name=value.
+ *
+ * @param  argc         Number of command line argmuments
+ * @param  argv         Array of command line arguments
+ * @param  name         Name of the parameter, including leading dashes and
+ *                      trailing =
+ * @param  defaultValue Value to return if the parameter was not given
+ *
+ * @return              The parsed value, or defaultValue if not given
+ */
+static int intFlagValue(
+    int argc,
+    char *argv[],
+    const char * const name,
+    const int defaultValue
+)
+{
+    const char * const value = flagValue(argc, argv, name);
+
+    return value ? atoi(value) : defaultValue;
 }
 
 /**
@@ -125,9 +334,8 @@ void write2dDoubleArray(
  * Generate, set up and run solve on a problem of problemDimension size with
  * the given precision.
  *
- * Carries out various set up features such as selecting optimimum number of
- * processors, padding of problem so that every processor can be assigned the
- * same amount of rows, as this is required by the implementation of solve.
+ * Set up (selecting the number of processors to use, and padding of problem)
+ * is carried out by createSolveContext.
  *
  * Also outputs solution to file, and allows solution to
  * be tested (and the result written to file) for correctness testing.
@@ -135,9 +343,20 @@ void write2dDoubleArray(
  * @param  problemDimension  Dimension of problem to generate and solve
  * @param  precision         Precision to solve generated problem to
  * @param  maxProcessors     Maximum number of processors allows
+ * @param  useProcessors     Number of processors to try to use (at most
+ *                           maxProcessors)
  * @param  rank              Rank of processor calling this function
  * @param  test              Flag to say whether to test the solution and write
  *                           test result to file
+ * @param  solver            SOLVER_ITERATIVE or SOLVER_DST
+ * @param  reference         Flag to say whether to compare an iterative
+ *                           solution with the direct solution
+ * @param  checkInterval     Check for convergence every checkInterval
+ *                           iterations
+ * @param  mixedPrecision    Flag to say whether to solve by defect
+ *                           correction, with sweeps in single precision
+ * @param  snapshotter       Snapshotter to write snapshots while solving, NULL
+ *                           to take no snapshots
  *
  * @return                   0 if success, error code otherwise
  */
@@ -145,66 +364,53 @@ static int runSolve(
     const int problemDimension,
     const double precision,
     int maxProcessors,
+    const int useProcessors,
     const int rank,
-    const int test
+    const int test,
+    const int solver,
+    const int reference,
+    const int checkInterval,
+    const int mixedPrecision,
+    Snapshotter * const snapshotter
 )
 {
-    int numProcessors = maxProcessors;
-
-    // This separates problem by rows, so cannot use more processes than rows
-    if (numProcessors > problemDimension) {
-        numProcessors = problemDimension;
-    }
-
-    // See if rows is divisible by number of processors
-    int leftoverRows = problemDimension % numProcessors;
-    int totalRows = problemDimension;
-
-    int rowsPerProcessor = (problemDimension - leftoverRows) / numProcessors;
-
-    // If number of rows not divisible by number of processors, we need to pad
-    if (leftoverRows) {
-        // We have leftover rows, so need to do one more row per processor
-        rowsPerProcessor++;
-
-        // Round number of rows to a multiple of rowsPerProcessor
-        totalRows = roundToMultiple(problemDimension, rowsPerProcessor);
+    SolveContext * const context = createSolveContext(
+        problemDimension,
+        useProcessors,
+        MPI_COMM_WORLD
+    );
 
-        // Only use enough processors to cover all the rows
-        numProcessors = totalRows / rowsPerProcessor;
+    if (!context) {
+        return -1;
     }
 
-    int shouldRun = rank < numProcessors;
-
-    MPI_Comm running_comm;
-    MPI_Comm_split(MPI_COMM_WORLD, shouldRun, rank, &running_comm);
+    // Not using these processors, so just clean up and return
+    if (!solveContextRunning(context)) {
+        freeSolveContext(context);
 
-    // Not using these processors, so just return
-    if (!shouldRun) {
         return 0;
     }
 
-    // Create problem array, including padding rows
-    double ** const problem = createTwoDDoubleArray(totalRows, problemDimension);
+    double ** const problem = solveContextProblem(context);
+
     // Load problem into problem array
     fillProblemArray(problem, problemDimension);
 
-    // Fill padding rows with 0.0
-    for (int row = problemDimension; row < totalRows; row++) {
-        memset(problem[row], 0.0, problemDimension);
-    }
-
     FILE * f;
 
+    // Keep direct solutions apart from iterative ones, to compare them
+    const char * const suffix = solver == SOLVER_DST ? "-dst" : "";
+
     // Open solution file and write input problem to file
     if (isMainThread(rank)) {
         char fileName[80];
         sprintf(
             fileName,
-            "./output/solution-%d-%g-%d.txt",
+            "./output/solution-%d-%g-%d%s.txt",
             problemDimension,
             precision,
-            maxProcessors
+            maxProcessors,
+            suffix
         );
 
         f = fopen(fileName, "w");
@@ -214,16 +420,29 @@ static int runSolve(
         write2dDoubleArray(f, problem, problemDimension);
     }
 
-    int error = solve(
-        problem,
-        problemDimension,
-        totalRows,
-        precision,
-        numProcessors,
-        rowsPerProcessor,
-        rank,
-        running_comm
-    );
+    int error;
+
+    if (solver == SOLVER_DST) {
+        error = solveDirectWithContext(context);
+    } else {
+        error = solveWithContext(
+            context,
+            precision,
+            checkInterval,
+            mixedPrecision,
+            snapshotter
+        );
+    }
+
+    if (!error && reference && solver != SOLVER_DST) {
+        double maxDifference;
+
+        error = directSolutionDifference(context, &maxDifference);
+
+        if (!error && isMainThread(rank)) {
+            printf(REFERENCE_DIFFERENCE, maxDifference);
+        }
+    }
 
     if (error) {
         /*
@@ -247,10 +466,11 @@ static int runSolve(
         char fileName[80];
         sprintf(
             fileName,
-            "./output/test-%d-%g-%d.txt",
+            "./output/test-%d-%g-%d%s.txt",
             problemDimension,
             precision,
-            maxProcessors
+            maxProcessors,
+            suffix
         );
 
         FILE * testFile = fopen(fileName, "w");
@@ -271,9 +491,7 @@ static int runSolve(
     }
 
     // Free memory
-    freeTwoDDoubleArray(problem);
-
-    MPI_Comm_free(&running_comm);
+    freeSolveContext(context);
 
     return error ? error : 0;
 }
@@ -379,8 +597,139 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    const int hugePageMode = parseHugePageMode(argc, argv);
+
+    if (hugePageMode < 0) {
+        if (isMainThread(rank)) {
+            printf(INVALID_HUGE_PAGES);
+        }
+
+        MPI_Finalize();
+
+        return -1;
+    }
+
+    setHugePageMode(hugePageMode);
+
+    const int solver = parseSolver(argc, argv);
+
+    if (solver < 0) {
+        if (isMainThread(rank)) {
+            printf(INVALID_SOLVER);
+        }
+
+        MPI_Finalize();
+
+        return -1;
+    }
+
+    if (solver == SOLVER_DST
+        && (mixedPrecisionFlagSet(argc, argv)
+            || referenceFlagSet(argc, argv)
+            || flagValue(argc, argv, "--check-every=")
+            || flagValue(argc, argv, "--snapshot"))) {
+
+        if (isMainThread(rank)) {
+            printf(INVALID_DST_OPTIONS);
+        }
+
+        MPI_Finalize();
+
+        return -1;
+    }
+
+    int useProcessors = numProcessors;
+    int checkInterval = intFlagValue(argc, argv, "--check-every=", 1);
+
+    if (checkInterval <= 0) {
+        if (isMainThread(rank)) {
+            printf(INVALID_CHECK_INTERVAL);
+        }
+
+        MPI_Finalize();
+
+        return -1;
+    }
+
+    if (autotuneFlagSet(argc, argv)) {
+        error = autotune(
+            problemDimension,
+            precision,
+            numProcessors,
+            rank,
+            &useProcessors,
+            &checkInterval
+        );
+
+        if (error) {
+            printf(MPI_ERROR, error);
+
+            MPI_Finalize();
+
+            return error;
+        }
+    }
+
+    const char * const snapshotPath = flagValue(argc, argv, "--snapshot=");
+    const int snapshotInterval = intFlagValue(
+        argc,
+        argv,
+        "--snapshot-every=",
+        100
+    );
+    const int snapshotMode = parseSnapshotMode(argc, argv);
+    const int snapshotDownsample = intFlagValue(
+        argc,
+        argv,
+        "--snapshot-downsample=",
+        10
+    );
+
+    if (snapshotInterval <= 0 || snapshotMode < 0 || snapshotDownsample <= 0) {
+        if (isMainThread(rank)) {
+            printf(INVALID_SNAPSHOT);
+        }
+
+        MPI_Finalize();
+
+        return -1;
+    }
+
+    // Every process holds the whole problem, so only main takes snapshots
+    Snapshotter *snapshotter = NULL;
+
+    if (snapshotPath && isMainThread(rank)) {
+        snapshotter = createSnapshotter(
+            snapshotPath,
+            snapshotInterval,
+            snapshotMode,
+            snapshotDownsample,
+            problemDimension
+        );
+
+        if (!snapshotter) {
+            printf(SNAPSHOT_ERROR);
+        }
+    }
+
     // Solve and clean up
-    int res = runSolve(problemDimension, precision, numProcessors, rank, test);
+    int res = runSolve(
+        problemDimension,
+        precision,
+        numProcessors,
+        useProcessors,
+        rank,
+        test,
+        solver,
+        referenceFlagSet(argc, argv),
+        checkInterval,
+        mixedPrecisionFlagSet(argc, argv),
+        snapshotter
+    );
+
+    if (snapshotter) {
+        freeSnapshotter(snapshotter);
+    }
 
     if (res) {
         printf(MPI_ERROR, res);
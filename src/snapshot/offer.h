@@ -0,0 +1,51 @@
+#ifndef SNAPSHOT_OFFER_H
+#define SNAPSHOT_OFFER_H
+
+#include "snapshot.h"
+
+/**
+ * Offer the current state of the grid for a snapshot, without waiting for
+ * any previous snapshot to be written.
+ *
+ * @param snapshotter Snapshotter to offer to (may be NULL, then does nothing)
+ * @param grid        The current grid
+ * @param iteration   The number of iterations completed so far
+ */
+void offerSnapshot(
+    Snapshotter * const snapshotter,
+    double ** const grid,
+    const int iteration
+);
+
+/**
+ * Offer the current state of a single precision grid for a snapshot, without
+ * waiting for any previous snapshot to be written.
+ *
+ * @param snapshotter Snapshotter to offer to (may be NULL, then does nothing)
+ * @param grid        The current grid
+ * @param iteration   The number of iterations completed so far
+ */
+void offerFloatSnapshot(
+    Snapshotter * const snapshotter,
+    float ** const grid,
+    const int iteration
+);
+
+/**
+ * Offer the current state of a grid held as a double precision base plus a
+ * single precision correction for a snapshot, without waiting for any
+ * previous snapshot to be written.
+ *
+ * @param snapshotter Snapshotter to offer to (may be NULL, then does nothing)
+ * @param base        The grid before correction
+ * @param correction  The current correction to base
+ * @param iteration   The number of iterations completed so far
+ */
+void offerCorrectedSnapshot(
+    Snapshotter * const snapshotter,
+    double ** const base,
+    float ** const correction,
+    const int iteration
+);
+
+#endif
@@ -0,0 +1,492 @@
+#define _DEFAULT_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "../array/array.h"
+#include "snapshot.h"
+#include "offer.h"
+
+/**
+ * State shared between the solver (which offers snapshots) and the background
+ * writer thread (which formats and writes them).
+ *
+ * The solver only ever copies into staging when the writer is not busy with
+ * it, and never waits for the writer, so a slow file or pipe causes snapshots
+ * to be skipped rather than stalling relaxation.
+ */
+struct Snapshotter {
+    char *path;
+    int interval;
+    int mode;
+    int downsample;
+    int problemDimension;
+
+    double **staging;
+    int stagedIteration;
+
+    // Guarded by lock
+    int busy;
+    int done;
+
+    // Only written by the solver, read by the writer once done is set
+    int skipped;
+
+    pthread_t writer;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+};
+
+/**
+ * Write residual statistics of the staged grid to the given file.
+ *
+ * @param f           File handle to write to
+ * @param snapshotter Snapshotter holding the staged grid
+ */
+static void writeStats(FILE * const f, const Snapshotter * const snapshotter)
+{
+    double ** const grid = snapshotter->staging;
+    const int dimension = snapshotter->problemDimension;
+
+    double maxResidual = 0.0;
+    double sumSquares = 0.0;
+    long points = 0;
+
+    for (int row = 1; row < dimension - 1; row++) {
+        for (int col = 1; col < dimension - 1; col++) {
+            const double residual = fabs(
+                (grid[row + 1][col] + grid[row - 1][col] +
+                 grid[row][col + 1] + grid[row][col - 1]) / 4 - grid[row][col]
+            );
+
+            if (residual > maxResidual) {
+                maxResidual = residual;
+            }
+
+            sumSquares += residual * residual;
+            points++;
+        }
+    }
+
+    fprintf(
+        f,
+        "Iteration %d: max residual %g, rms residual %g\n",
+        snapshotter->stagedIteration,
+        maxResidual,
+        points ? sqrt(sumSquares / points) : 0.0
+    );
+}
+
+/**
+ * Write the staged grid (every downsample'th row and column of it) to the
+ * given file.
+ *
+ * @param f           File handle to write to
+ * @param snapshotter Snapshotter holding the staged grid
+ * @param downsample  Only write every downsample'th row and column
+ */
+static void writeGrid(
+    FILE * const f,
+    const Snapshotter * const snapshotter,
+    const int downsample
+)
+{
+    double ** const grid = snapshotter->staging;
+    const int dimension = snapshotter->problemDimension;
+
+    fprintf(f, "Iteration %d:\n", snapshotter->stagedIteration);
+
+    for (int row = 0; row < dimension; row += downsample) {
+        for (int col = 0; col < dimension; col += downsample) {
+            fprintf(f, "%10f ", grid[row][col]);
+        }
+        fputs("\n", f);
+    }
+}
+
+/**
+ * Open the snapshot file for writing, without blocking.
+ *
+ * Opening a named pipe normally blocks until a reader attaches, which would
+ * leave the writer thread (and so freeSnapshotter) stuck forever if none
+ * ever does. Instead the pipe is opened non-blocking, which fails straight
+ * away with no reader, so the caller can skip the snapshot and try again
+ * with the next one. Once open, writes block as normal.
+ *
+ * @param  path File or named pipe to open
+ *
+ * @return      File handle, NULL if it could not be opened (yet)
+ */
+static FILE *openSnapshotFile(const char * const path)
+{
+    const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK, 0666);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    const int flags = fcntl(fd, F_GETFL);
+
+    if (flags < 0 || fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) < 0) {
+        close(fd);
+
+        return NULL;
+    }
+
+    FILE * const f = fdopen(fd, "w");
+
+    if (!f) {
+        close(fd);
+    }
+
+    return f;
+}
+
+/**
+ * Background writer thread. Waits for staged snapshots and writes them out.
+ *
+ * The file is opened here rather than by the solver, so the solver never
+ * waits on it. SIGPIPE is blocked in this thread (see createSnapshotter), so
+ * if the reader of a named pipe goes away writes fail with EPIPE instead of
+ * killing the process, and the writer stops writing.
+ *
+ * @param  arg The Snapshotter to serve
+ *
+ * @return     NULL
+ */
+static void *runWriter(void *arg)
+{
+    Snapshotter * const snapshotter = (Snapshotter *)arg;
+
+    FILE *f = NULL;
+    int failed = 0;
+    int unwritten = 0;
+
+    pthread_mutex_lock(&snapshotter->lock);
+
+    for (;;) {
+        while (!snapshotter->busy && !snapshotter->done) {
+            pthread_cond_wait(&snapshotter->ready, &snapshotter->lock);
+        }
+
+        if (!snapshotter->busy) {
+            break;
+        }
+
+        // Staging now belongs to this thread until busy is cleared
+        pthread_mutex_unlock(&snapshotter->lock);
+
+        if (!f && !failed) {
+            f = openSnapshotFile(snapshotter->path);
+        }
+
+        if (f) {
+            if (snapshotter->mode == SNAPSHOT_STATS) {
+                writeStats(f, snapshotter);
+            } else {
+                writeGrid(
+                    f,
+                    snapshotter,
+                    snapshotter->mode == SNAPSHOT_DOWNSAMPLED
+                        ? snapshotter->downsample
+                        : 1
+                );
+            }
+
+            if (fflush(f) == EOF || ferror(f)) {
+                // Reader went away (EPIPE) or the disk filled up: give up
+                fclose(f);
+
+                f = NULL;
+                failed = 1;
+            }
+        } else {
+            unwritten++;
+        }
+
+        pthread_mutex_lock(&snapshotter->lock);
+
+        snapshotter->busy = 0;
+    }
+
+    pthread_mutex_unlock(&snapshotter->lock);
+
+    if (f) {
+        if (snapshotter->skipped + unwritten) {
+            fprintf(
+                f,
+                "Skipped %d snapshots while writing.\n",
+                snapshotter->skipped + unwritten
+            );
+        }
+
+        fclose(f);
+    }
+
+    return NULL;
+}
+
+/**
+ * Create a snapshotter, and start its background writer thread.
+ *
+ * Note: freeSnapshotter should always be called on the returned snapshotter
+ * to stop the writer thread and clean up memory.
+ *
+ * @param  path             File or named pipe to write snapshots to
+ * @param  interval         Take a snapshot every interval iterations
+ * @param  mode             SNAPSHOT_FULL, SNAPSHOT_DOWNSAMPLED or
+ *                          SNAPSHOT_STATS
+ * @param  downsample       Write every downsample'th row and column (only
+ *                          used by SNAPSHOT_DOWNSAMPLED)
+ * @param  problemDimension Dimension of the problem being solved
+ *
+ * @return                  Pointer to the created snapshotter, NULL if it
+ *                          could not be created
+ */
+Snapshotter *createSnapshotter(
+    const char * const path,
+    const int interval,
+    const int mode,
+    const int downsample,
+    const int problemDimension
+)
+{
+    Snapshotter * const snapshotter = (Snapshotter *)calloc(
+        1,
+        sizeof(Snapshotter)
+    );
+
+    if (!snapshotter) {
+        return NULL;
+    }
+
+    snapshotter->path = (char *)malloc(strlen(path) + 1);
+    snapshotter->staging = createTwoDDoubleArray(
+        problemDimension,
+        problemDimension
+    );
+
+    if (!snapshotter->path || !snapshotter->staging) {
+        free(snapshotter->path);
+
+        if (snapshotter->staging) {
+            freeTwoDDoubleArray(snapshotter->staging);
+        }
+
+        free(snapshotter);
+
+        return NULL;
+    }
+
+    strcpy(snapshotter->path, path);
+    snapshotter->interval = interval;
+    snapshotter->mode = mode;
+    snapshotter->downsample = downsample;
+    snapshotter->problemDimension = problemDimension;
+
+    pthread_mutex_init(&snapshotter->lock, NULL);
+    pthread_cond_init(&snapshotter->ready, NULL);
+
+    // The writer inherits this mask, so only it has SIGPIPE blocked
+    sigset_t pipeSignal, oldMask;
+
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &oldMask);
+
+    const int error = pthread_create(
+        &snapshotter->writer,
+        NULL,
+        runWriter,
+        snapshotter
+    );
+
+    pthread_sigmask(SIG_SETMASK, &oldMask, NULL);
+
+    if (error) {
+        pthread_cond_destroy(&snapshotter->ready);
+        pthread_mutex_destroy(&snapshotter->lock);
+        freeTwoDDoubleArray(snapshotter->staging);
+        free(snapshotter->path);
+        free(snapshotter);
+
+        return NULL;
+    }
+
+    return snapshotter;
+}
+
+/**
+ * Check if the grid should be copied into the staging buffer for a snapshot
+ * at the given iteration. Never waits: if the writer is still busy with the
+ * previous snapshot, this one is skipped.
+ *
+ * If this returns 1, the lock is held, and the caller must copy the grid into
+ * staging and then call stageSnapshot.
+ *
+ * @param  snapshotter Snapshotter to check (may be NULL)
+ * @param  iteration   The number of iterations completed so far
+ *
+ * @return             1 if the grid should be copied, 0 otherwise
+ */
+static int claimStaging(Snapshotter * const snapshotter, const int iteration)
+{
+    if (!snapshotter || iteration % snapshotter->interval) {
+        return 0;
+    }
+
+    if (pthread_mutex_trylock(&snapshotter->lock)) {
+        snapshotter->skipped++;
+
+        return 0;
+    }
+
+    if (snapshotter->busy) {
+        pthread_mutex_unlock(&snapshotter->lock);
+
+        snapshotter->skipped++;
+
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Hand the copied grid in the staging buffer to the writer thread. Partners
+ * the above claimStaging function.
+ *
+ * @param snapshotter Snapshotter holding the copied grid
+ * @param iteration   The number of iterations completed so far
+ */
+static void stageSnapshot(Snapshotter * const snapshotter, const int iteration)
+{
+    snapshotter->stagedIteration = iteration;
+    snapshotter->busy = 1;
+
+    pthread_cond_signal(&snapshotter->ready);
+    pthread_mutex_unlock(&snapshotter->lock);
+}
+
+/**
+ * Offer the current state of the grid for a snapshot. If this is a snapshot
+ * iteration, the grid is copied into the staging buffer and handed to the
+ * writer thread. Never waits: if the writer is still busy with the previous
+ * snapshot, this one is skipped.
+ *
+ * @param snapshotter Snapshotter to offer to (may be NULL, then does nothing)
+ * @param grid        The current grid
+ * @param iteration   The number of iterations completed so far
+ */
+void offerSnapshot(
+    Snapshotter * const snapshotter,
+    double ** const grid,
+    const int iteration
+)
+{
+    if (!claimStaging(snapshotter, iteration)) {
+        return;
+    }
+
+    const int dimension = snapshotter->problemDimension;
+
+    for (int row = 0; row < dimension; row++) {
+        memcpy(snapshotter->staging[row], grid[row], dimension * sizeof(double));
+    }
+
+    stageSnapshot(snapshotter, iteration);
+}
+
+/**
+ * Offer the current state of a single precision grid for a snapshot. Partners
+ * the above offerSnapshot function.
+ *
+ * @param snapshotter Snapshotter to offer to (may be NULL, then does nothing)
+ * @param grid        The current grid
+ * @param iteration   The number of iterations completed so far
+ */
+void offerFloatSnapshot(
+    Snapshotter * const snapshotter,
+    float ** const grid,
+    const int iteration
+)
+{
+    if (!claimStaging(snapshotter, iteration)) {
+        return;
+    }
+
+    const int dimension = snapshotter->problemDimension;
+
+    for (int row = 0; row < dimension; row++) {
+        for (int col = 0; col < dimension; col++) {
+            snapshotter->staging[row][col] = grid[row][col];
+        }
+    }
+
+    stageSnapshot(snapshotter, iteration);
+}
+
+/**
+ * Offer the current state of a grid held as a double precision base plus a
+ * single precision correction for a snapshot, i.e. while a correction to the
+ * grid is being relaxed. Partners the above offerSnapshot function.
+ *
+ * @param snapshotter Snapshotter to offer to (may be NULL, then does nothing)
+ * @param base        The grid before correction
+ * @param correction  The current correction to base
+ * @param iteration   The number of iterations completed so far
+ */
+void offerCorrectedSnapshot(
+    Snapshotter * const snapshotter,
+    double ** const base,
+    float ** const correction,
+    const int iteration
+)
+{
+    if (!claimStaging(snapshotter, iteration)) {
+        return;
+    }
+
+    const int dimension = snapshotter->problemDimension;
+
+    for (int row = 0; row < dimension; row++) {
+        for (int col = 0; col < dimension; col++) {
+            snapshotter->staging[row][col] = base[row][col]
+                + correction[row][col];
+        }
+    }
+
+    stageSnapshot(snapshotter, iteration);
+}
+
+/**
+ * Frees a given snapshotter. Waits for the writer thread to finish writing
+ * any staged snapshot, then stops it and closes the file.
+ *
+ * @param snapshotter The snapshotter to free
+ */
+void freeSnapshotter(Snapshotter * const snapshotter)
+{
+    pthread_mutex_lock(&snapshotter->lock);
+
+    snapshotter->done = 1;
+
+    pthread_cond_signal(&snapshotter->ready);
+    pthread_mutex_unlock(&snapshotter->lock);
+
+    pthread_join(snapshotter->writer, NULL);
+
+    pthread_cond_destroy(&snapshotter->ready);
+    pthread_mutex_destroy(&snapshotter->lock);
+
+    freeTwoDDoubleArray(snapshotter->staging);
+    free(snapshotter->path);
+    free(snapshotter);
+}
@@ -0,0 +1,52 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "../solve/export.h"
+
+/**
+ * Snapshot modes for createSnapshotter.
+ *
+ * SNAPSHOT_FULL        Write the whole grid
+ * SNAPSHOT_DOWNSAMPLED Write every downsample'th row and column of the grid
+ * SNAPSHOT_STATS       Write residual statistics only
+ */
+#define SNAPSHOT_FULL 0
+#define SNAPSHOT_DOWNSAMPLED 1
+#define SNAPSHOT_STATS 2
+
+/**
+ * Periodically writes snapshots of the grid being solved from a background
+ * thread.
+ */
+typedef struct Snapshotter Snapshotter;
+
+/**
+ * Create a snapshotter, and start its background writer thread.
+ *
+ * @param  path             File or named pipe to write snapshots to
+ * @param  interval         Take a snapshot every interval iterations
+ * @param  mode             SNAPSHOT_FULL, SNAPSHOT_DOWNSAMPLED or
+ *                          SNAPSHOT_STATS
+ * @param  downsample       Write every downsample'th row and column (only
+ *                          used by SNAPSHOT_DOWNSAMPLED)
+ * @param  problemDimension Dimension of the problem being solved
+ *
+ * @return                  Pointer to the created snapshotter, NULL if it
+ *                          could not be created
+ */
+LIBSOLVE_API Snapshotter *createSnapshotter(
+    const char * const path,
+    const int interval,
+    const int mode,
+    const int downsample,
+    const int problemDimension
+);
+
+/**
+ * Frees a given snapshotter, once any staged snapshot has been written.
+ *
+ * @param snapshotter The snapshotter to free
+ */
+LIBSOLVE_API void freeSnapshotter(Snapshotter * const snapshotter);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef SOLVE_EXPORT_H
+#define SOLVE_EXPORT_H
+
+/**
+ * Marks functions that are part of the library's public API. The library is
+ * compiled with -fvisibility=hidden, so everything else stays internal and
+ * cannot clash with symbols of the application it is linked into.
+ */
+#if defined(__GNUC__)
+#define LIBSOLVE_API __attribute__((visibility("default")))
+#else
+#define LIBSOLVE_API
+#endif
+
+#endif
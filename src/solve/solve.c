@@ -1,9 +1,25 @@
+#include <float.h>
 #include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include <mpi.h>
 #include <stdio.h>
 
 #include "../array/array.h"
+#include "../dst/dst.h"
+#include "../snapshot/offer.h"
+#include "../snapshot/snapshot.h"
+#include "solve.h"
+#include "sweep.h"
+
+#define PI 3.14159265358979323846
+
+/**
+ * Number of units in the last place (relative to the largest value being
+ * relaxed) a float relaxation can be out by, from rounding the average of
+ * four neighbours plus the residual.
+ */
+#define FLOAT_ROUNDING_ULPS 4
 
 /**
  * Relax a subset of rows in the updatedProblem array
@@ -51,6 +67,46 @@ static void relaxRows(
     }
 }
 
+/**
+ * Update the first rows of the given problem to match the updatedProblem, and
+ * check if any value changed. All but the first and last of the given rows,
+ * and all but the first and last column, are updated.
+ *
+ * @param  problem          The two dimensional problem array to update into
+ * @param  updatedProblem   The two dimensional updatedProblem array to update
+ *                          from
+ * @param  problemDimension The number of columns in the problem arrays
+ * @param  rows             The number of rows to update, including the fixed
+ *                          first and last rows
+ *
+ * @return                  1 if no update was made, 0 otherwise
+ */
+static int updateRows(
+    double ** const problem,
+    double ** const updatedProblem,
+    const int problemDimension,
+    const int rows
+)
+{
+    int solved = 1;
+
+    for (int row = 1; row < rows - 1; row++) {
+        for (int col = 1; col < problemDimension - 1; col++) {
+            if (problem[row][col] == updatedProblem[row][col]) {
+                continue;
+            }
+
+            problem[row][col] = updatedProblem[row][col];
+
+            if (solved) {
+                solved = 0;
+            }
+        }
+    }
+
+    return solved;
+}
+
 /**
  * Update the given problem to match the updatedProblem. Also checks if
  * any value changes as it does this. If no values changed in the last pass, we
@@ -69,6 +125,163 @@ static int updateProblem(
     double ** const updatedProblem,
     const int problemDimension
 )
+{
+    return updateRows(
+        problem,
+        updatedProblem,
+        problemDimension,
+        problemDimension
+    );
+}
+
+/**
+ * Copy the rows of the given problem that can change (all but the first and
+ * last) from updatedProblem into problem.
+ *
+ * @param  problem          The two dimensional problem array to copy into
+ * @param  updatedProblem   The two dimensional updatedProblem array to copy
+ *                          from
+ * @param  problemDimension The dimension of the problem arrays
+ */
+static void copyProblem(
+    double ** const problem,
+    double ** const updatedProblem,
+    const int problemDimension
+)
+{
+    for (int row = 1; row < problemDimension - 1; row++) {
+        memcpy(
+            problem[row],
+            updatedProblem[row],
+            problemDimension * sizeof(double)
+        );
+    }
+}
+
+/**
+ * Relax a subset of rows in the updatedProblem array, in single precision.
+ * Partners the above relaxRows function.
+ *
+ * @param updatedProblem   The array to perform relaxation on
+ * @param problemDimension The dimension of the problem array to perform
+ *                         relaxation on
+ * @param startRowIndex    The index of the first row to relax
+ * @param rowsToRelax      The number of rows to relax
+ * @param precision        The precision to relax values to
+ */
+static void relaxRowsFloat(
+    float ** const updatedProblem,
+    const int problemDimension,
+    const int startRowIndex,
+    const int rowsToRelax,
+    const float precision
+)
+{
+    float newValue;
+
+    int lastRow = startRowIndex + rowsToRelax;
+
+    // Do not try to relax fixed edge row, or any row past this
+    if (lastRow > problemDimension - 1) {
+        lastRow = problemDimension - 1;
+    }
+
+    // Skip first row
+    int startRow = startRowIndex == 0 ? 1 : startRowIndex;
+
+    for (int row = startRow; row < lastRow; row++) {
+        for (int col = 1; col < problemDimension - 1; col++) {
+            newValue = (updatedProblem[row + 1][col] +
+                        updatedProblem[row - 1][col] +
+                        updatedProblem[row][col + 1] +
+                        updatedProblem[row][col - 1]) / 4;
+
+            if (fabsf(newValue - updatedProblem[row][col]) < precision) {
+                continue;
+            }
+
+            updatedProblem[row][col] = newValue;
+        }
+    }
+}
+
+/**
+ * Relax a subset of rows of a correction in the updatedProblem array, in
+ * single precision. Partners the above relaxRowsFloat function, but each
+ * value is relaxed to the average of its neighbours plus the residual of the
+ * problem being corrected at that point.
+ *
+ * The residual is held four times over, so it is added in with the
+ * neighbours before the left one (which has just been relaxed), leaving
+ * only an addition and a division waiting on it, as in relaxRows.
+ *
+ * @param updatedProblem   The array to perform relaxation on
+ * @param residual         Four times the residual of the problem being
+ *                         corrected
+ * @param problemDimension The dimension of the problem array to perform
+ *                         relaxation on
+ * @param startRowIndex    The index of the first row to relax
+ * @param rowsToRelax      The number of rows to relax
+ * @param precision        The precision to relax values to
+ */
+static void relaxCorrectionRowsFloat(
+    float ** const updatedProblem,
+    float ** const residual,
+    const int problemDimension,
+    const int startRowIndex,
+    const int rowsToRelax,
+    const float precision
+)
+{
+    float newValue;
+
+    int lastRow = startRowIndex + rowsToRelax;
+
+    // Do not try to relax fixed edge row, or any row past this
+    if (lastRow > problemDimension - 1) {
+        lastRow = problemDimension - 1;
+    }
+
+    // Skip first row
+    int startRow = startRowIndex == 0 ? 1 : startRowIndex;
+
+    for (int row = startRow; row < lastRow; row++) {
+        for (int col = 1; col < problemDimension - 1; col++) {
+            newValue = (updatedProblem[row + 1][col] +
+                        updatedProblem[row - 1][col] +
+                        updatedProblem[row][col + 1] +
+                        residual[row][col] +
+                        updatedProblem[row][col - 1]) / 4;
+
+            if (fabsf(newValue - updatedProblem[row][col]) < precision) {
+                continue;
+            }
+
+            updatedProblem[row][col] = newValue;
+        }
+    }
+}
+
+/**
+ * Update the given single precision problem to match the updatedProblem, and
+ * check if any value changed by stopPrecision or more. Partners the above
+ * updateProblem function.
+ *
+ * @param  problem          The two dimensional problem array to update into
+ * @param  updatedProblem   The two dimensional updatedProblem array to update
+ *                          from
+ * @param  problemDimension The dimension of the problem arrays
+ * @param  stopPrecision    The smallest change that counts as an update
+ *
+ * @return                  1 if no update was made (problem is within
+ *                          stopPrecision), 0 otherwise
+ */
+static int updateProblemFloat(
+    float ** const problem,
+    float ** const updatedProblem,
+    const int problemDimension,
+    const float stopPrecision
+)
 {
     int solved = 1;
 
@@ -78,11 +291,13 @@ static int updateProblem(
                 continue;
             }
 
-            problem[row][col] = updatedProblem[row][col];
+            if (solved && fabsf(updatedProblem[row][col] - problem[row][col])
+                >= stopPrecision) {
 
-            if (solved) {
                 solved = 0;
             }
+
+            problem[row][col] = updatedProblem[row][col];
         }
     }
 
@@ -90,111 +305,477 @@ static int updateProblem(
 }
 
 /**
- * Solve the given problem to the given precision in parallel, using the given
- * number of processors.
+ * Copy the rows of the given single precision problem that can change from
+ * updatedProblem into problem. Partners the above copyProblem function.
+ *
+ * @param  problem          The two dimensional problem array to copy into
+ * @param  updatedProblem   The two dimensional updatedProblem array to copy
+ *                          from
+ * @param  problemDimension The dimension of the problem arrays
+ */
+static void copyProblemFloat(
+    float ** const problem,
+    float ** const updatedProblem,
+    const int problemDimension
+)
+{
+    for (int row = 1; row < problemDimension - 1; row++) {
+        memcpy(
+            problem[row],
+            updatedProblem[row],
+            problemDimension * sizeof(float)
+        );
+    }
+}
+
+/**
+ * Measure how long relaxing, and checking for convergence, take per point
+ * of a problem of the given dimension on the calling processor. Used to
+ * calibrate the autotuner's cost model.
+ *
+ * Times a few sweeps over a slab of (up to) 256 full width rows of a
+ * generated problem.
  *
- * @param  problem          The problem to solve (including padding rows)
- * @param  problemRows      The rows of the given problem array that are part
- *                          of the problem
- * @param  totalRows        The total rows of the given problem array
- * @param  precision        The precision to solve the problem to
- * @param  numProcessors    The number of processors being used to solve the
- *                          problem
- * @param  rowsPerProcessor The rows each processor should relax
- * @param  rank             The rank of the calling processor
- * @param  running_comm     Communicator containing all processes that are
- *                          running this function
+ * @param  problemDimension The dimension of problem to time
+ * @param  relaxTime        Set to the seconds taken to relax one point
+ * @param  updateTime       Set to the seconds taken to check and update one
+ *                          point
  *
  * @return                  0 if success, error code otherwise
  */
-int solve(
-    double ** const problem,
+int measureSweepTimes(
     const int problemDimension,
-    const int totalRows,
-    const double precision,
-    const int numProcessors,
-    const int rowsPerProcessor,
-    const int rank,
-    MPI_Comm running_comm
+    double * const relaxTime,
+    double * const updateTime
 )
 {
+    const int sweeps = 5;
+    const int rows = problemDimension < 256 ? problemDimension : 256;
+
+    double ** const problem = createTwoDDoubleArray(rows, problemDimension);
     double ** const updatedProblem = createTwoDDoubleArray(
-        totalRows,
+        rows,
         problemDimension
     );
 
-    // Initially set updatedProblem to be the same as problem
-    for (int i = 0; i < totalRows; i++) {
-        for (int j = 0; j < problemDimension; j++) {
-            updatedProblem[i][j] = problem[i][j];
+    if (!problem || !updatedProblem) {
+        if (problem) {
+            freeTwoDDoubleArray(problem);
+        }
+
+        if (updatedProblem) {
+            freeTwoDDoubleArray(updatedProblem);
+        }
+
+        return -1;
+    }
+
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < problemDimension; col++) {
+            updatedProblem[row][col] = (row * 31 + col * 17) % 100;
         }
     }
 
-    // Create subarray type to extract doubles from 2D problemArray
-    int totalSize[2] = {totalRows, problemDimension};
+    double relaxSeconds = 0.0;
+    double updateSeconds = 0.0;
+
+    for (int sweep = 0; sweep < sweeps; sweep++) {
+        double start = MPI_Wtime();
+
+        // Tiny precision so that (almost) every point is written
+        relaxRows(updatedProblem, problemDimension, 0, rows - 1, 1e-12);
+
+        relaxSeconds += MPI_Wtime() - start;
+
+        start = MPI_Wtime();
+
+        updateRows(problem, updatedProblem, problemDimension, rows);
+
+        updateSeconds += MPI_Wtime() - start;
+    }
+
+    // Both skip the fixed first and last rows and columns of the slab
+    const double points = (double)sweeps * (rows - 2) * (problemDimension - 2);
+
+    // Problems too small to have any interior points cost nothing to relax
+    *relaxTime = points > 0 ? relaxSeconds / points : 0.0;
+    *updateTime = points > 0 ? updateSeconds / points : 0.0;
+
+    freeTwoDDoubleArray(problem);
+    freeTwoDDoubleArray(updatedProblem);
+
+    return 0;
+}
+
+/**
+ * Persistent state for solving a sequence of problems of the same dimension.
+ *
+ * Holds the decomposition of the problem between processors, the
+ * communicator and datatypes used to share relaxed rows, and both problem
+ * arrays, so that these are only set up once. The problem array keeps the
+ * last solution, so the next solve starts from it (warm start).
+ *
+ * Mixed precision solves also keep single precision arrays for the
+ * correction being relaxed (and its residual), with their own datatypes.
+ */
+struct SolveContext {
+    int problemDimension;
+    int totalRows;
+    int numProcessors;
+    int rowsPerProcessor;
+    int rank;
+    int running;
+    int iterations;
+
+    MPI_Comm running_comm;
+    MPI_Datatype type;
+    MPI_Datatype subArrayType;
+    int *displs;
+    int *sendCounts;
+
+    double **problem;
+    double **updatedProblem;
+
+    // Only created by the first mixed precision solve
+    MPI_Datatype floatType;
+    MPI_Datatype floatSubArrayType;
+    float **floatProblem;
+    float **floatUpdatedProblem;
+    float **floatResidual;
+
+    // Only created by the first direct solve
+    DstPlan *dstPlan;
+    double *directRows;
+    double *directSendBuffer;
+    double *directReceiveBuffer;
+    double *directGathered;
+};
+
+/**
+ * Round input to the first value greater than input that is divisble by given
+ * multiple.
+ *
+ * @param  input    Value to round
+ * @param  multiple Value that returned value should be divisible by
+ *
+ * @return          First value greater than input that is divisible by given
+ *                  multiple
+ */
+static int roundToMultiple(const int input, const int multiple)
+{
+    const int remainder = input % multiple;
+
+    if (!remainder) {
+        return input;
+    }
+
+    return input + multiple - remainder;
+}
+
+/**
+ * Create the datatype for one processor's rows of a problem array, with its
+ * extent set to one (padded) row so that displacements count rows.
+ *
+ * @param  totalRows        The total rows of the problem array
+ * @param  problemDimension The dimension of the problem
+ * @param  rowsPerProcessor The rows each processor relaxes
+ * @param  rowStride        Elements between the start of each row
+ * @param  elementType      MPI_DOUBLE or MPI_FLOAT
+ * @param  elementSize      Size of each element, in bytes
+ * @param  type             Set to the underlying subarray type
+ * @param  subArrayType     Set to the resized, committed subarray type
+ *
+ * @return                  0 if success, error code otherwise
+ */
+static int createRowsType(
+    const int totalRows,
+    const int problemDimension,
+    const int rowsPerProcessor,
+    const int rowStride,
+    MPI_Datatype elementType,
+    const size_t elementSize,
+    MPI_Datatype * const type,
+    MPI_Datatype * const subArrayType
+)
+{
+    // Create subarray type to extract elements from 2D problemArray
+    int totalSize[2] = {totalRows, rowStride};
     int processorSize[2] = {rowsPerProcessor, problemDimension};
     int start[2]   = {0, 0};
-    MPI_Datatype type, subArrayType;
-
-    int error;
 
-    error = MPI_Type_create_subarray(
+    int error = MPI_Type_create_subarray(
         2,
         totalSize,
         processorSize,
         start,
         MPI_ORDER_C,
-        MPI_DOUBLE,
-        &type
+        elementType,
+        type
     );
 
-    // Set extent to one row (n doubles)
+    if (error) {
+        return error;
+    }
+
+    // Set extent to one (padded) row
     error = MPI_Type_create_resized(
-        type,
+        *type,
         0,
-        problemDimension * sizeof(double),
-        &subArrayType
+        rowStride * elementSize,
+        subArrayType
     );
 
-    error = MPI_Type_commit(&subArrayType);
-
     if (error) {
         return error;
     }
 
-    int displs[numProcessors];
-    int sendCounts[numProcessors];
+    return MPI_Type_commit(subArrayType);
+}
 
-    for (int i = 0; i < numProcessors; i++) {
-        // Only sending one item of type 'subArrayType' from each processor
-        sendCounts[i] = 1;
-        // Extent is per row so displace each by number of rows per processor
-        displs[i] = i * rowsPerProcessor;
+/**
+ * Create a context for solving problems of the given dimension in parallel.
+ *
+ * Selects how many processors to use, and pads the problem so that every
+ * processor can be assigned the same amount of rows, as this is required by
+ * the implementation of solve. Processors that are not needed get a context
+ * that is not running (see solveContextRunning).
+ *
+ * Must be called by every processor in comm.
+ *
+ * Note: freeSolveContext should always be called on the returned context to
+ * clean up memory and MPI resources.
+ *
+ * @param  problemDimension Dimension of problems to be solved
+ * @param  useProcessors    Maximum number of processors in comm to use
+ * @param  comm             Communicator containing all processes that may
+ *                          take part in solving
+ *
+ * @return                  Pointer to the created context, NULL if it could
+ *                          not be created (or problemDimension or
+ *                          useProcessors is not positive)
+ */
+SolveContext *createSolveContext(
+    const int problemDimension,
+    const int useProcessors,
+    MPI_Comm comm
+)
+{
+    if (problemDimension <= 0 || useProcessors <= 0) {
+        return NULL;
     }
 
-    const int startRowIndex = rank * rowsPerProcessor;
-    int solved = 0;
+    SolveContext * const context = (SolveContext *)calloc(
+        1,
+        sizeof(SolveContext)
+    );
 
-    while (!solved) {
-        // startRowIndex is different for each process
-        relaxRows(
-            updatedProblem,
-            problemDimension,
-            startRowIndex,
-            rowsPerProcessor,
-            precision
-        );
+    if (!context) {
+        return NULL;
+    }
+
+    context->type = MPI_DATATYPE_NULL;
+    context->subArrayType = MPI_DATATYPE_NULL;
+    context->floatType = MPI_DATATYPE_NULL;
+    context->floatSubArrayType = MPI_DATATYPE_NULL;
+
+    int rank, commSize;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &commSize);
+
+    int numProcessors = useProcessors < commSize ? useProcessors : commSize;
+
+    // This separates problem by rows, so cannot use more processes than rows
+    if (numProcessors > problemDimension) {
+        numProcessors = problemDimension;
+    }
+
+    // See if rows is divisible by number of processors
+    int leftoverRows = problemDimension % numProcessors;
+    int totalRows = problemDimension;
+
+    int rowsPerProcessor = (problemDimension - leftoverRows) / numProcessors;
+
+    // If number of rows not divisible by number of processors, we need to pad
+    if (leftoverRows) {
+        // We have leftover rows, so need to do one more row per processor
+        rowsPerProcessor++;
+
+        // Round number of rows to a multiple of rowsPerProcessor
+        totalRows = roundToMultiple(problemDimension, rowsPerProcessor);
+
+        // Only use enough processors to cover all the rows
+        numProcessors = totalRows / rowsPerProcessor;
+    }
+
+    context->problemDimension = problemDimension;
+    context->totalRows = totalRows;
+    context->numProcessors = numProcessors;
+    context->rowsPerProcessor = rowsPerProcessor;
+    context->rank = rank;
+    context->running = rank < numProcessors;
+
+    MPI_Comm_split(comm, context->running, rank, &context->running_comm);
+
+    // Not using these processors, so nothing else to set up
+    if (!context->running) {
+        return context;
+    }
+
+    // Create problem arrays, including padding rows (created filled with 0.0)
+    context->problem = createTwoDDoubleArray(totalRows, problemDimension);
+    context->updatedProblem = createTwoDDoubleArray(
+        totalRows,
+        problemDimension
+    );
+    context->displs = (int *)malloc(numProcessors * sizeof(int));
+    context->sendCounts = (int *)malloc(numProcessors * sizeof(int));
+
+    if (!context->problem || !context->updatedProblem
+        || !context->displs || !context->sendCounts) {
+
+        freeSolveContext(context);
+
+        return NULL;
+    }
+
+    // Rows are padded in memory, so step between them by the row stride
+    if (createRowsType(
+        totalRows,
+        problemDimension,
+        rowsPerProcessor,
+        twoDDoubleArrayRowStride(problemDimension),
+        MPI_DOUBLE,
+        sizeof(double),
+        &context->type,
+        &context->subArrayType
+    )) {
+        freeSolveContext(context);
+
+        return NULL;
+    }
+
+    for (int i = 0; i < numProcessors; i++) {
+        // Only sending one item of type 'subArrayType' from each processor
+        context->sendCounts[i] = 1;
+        // Extent is per row so displace each by number of rows per processor
+        context->displs[i] = i * rowsPerProcessor;
+    }
+
+    return context;
+}
+
+/**
+ * Checks if the calling processor takes part in solving with this context.
+ *
+ * @param  context The context to check
+ *
+ * @return         1 if running, 0 otherwise
+ */
+int solveContextRunning(const SolveContext * const context)
+{
+    return context->running;
+}
+
+/**
+ * Get the problem array of this context (including padding rows), to fill
+ * with a problem before solving and read the solution from after. Between
+ * solves it holds the last solution, so a sequence of related problems can
+ * be solved by only updating the values that change (e.g. the edges), and
+ * each solve will warm start from the last solution.
+ *
+ * @param  context The context to get the problem array of
+ *
+ * @return         The problem array, NULL if this processor is not running
+ */
+double **solveContextProblem(const SolveContext * const context)
+{
+    return context->problem;
+}
+
+/**
+ * Get the number of iterations the last solve with this context took.
+ *
+ * @param  context The context to get the iterations of
+ *
+ * @return         Number of iterations, 0 if not solved yet
+ */
+int solveContextIterations(const SolveContext * const context)
+{
+    return context->iterations;
+}
+
+/**
+ * Relax the problem in the given context in double precision until no value
+ * changes by the given precision or more.
+ *
+ * @param  context       The context holding the problem to solve
+ * @param  precision     The precision to solve the problem to
+ * @param  checkInterval Check for convergence every checkInterval
+ *                       iterations
+ * @param  snapshotter   Snapshotter to offer the problem to after every
+ *                       iteration, NULL to take no snapshots
+ * @param  iteration     Number of iterations so far, updated as iterating
+ *
+ * @return               0 if success, error code otherwise
+ */
+static int iterate(
+    SolveContext * const context,
+    const double precision,
+    const int checkInterval,
+    Snapshotter * const snapshotter,
+    int * const iteration
+)
+{
+    double ** const problem = context->problem;
+    double ** const updatedProblem = context->updatedProblem;
+    const int problemDimension = context->problemDimension;
+    const int rowsPerProcessor = context->rowsPerProcessor;
+
+    // Initially set updatedProblem to be the same as problem
+    for (int row = 0; row < context->totalRows; row++) {
+        memcpy(
+            updatedProblem[row],
+            problem[row],
+            problemDimension * sizeof(double)
+        );
+    }
+
+    const int startRowIndex = context->rank * rowsPerProcessor;
+    int solved = 0;
+    int error;
+
+    while (!solved) {
+        const int checkIteration = (*iteration + 1) % checkInterval == 0;
+
+        /*
+         * Convergence is checked against the previous iteration. Every
+         * iteration checks when checkInterval is 1, so problem is already the
+         * previous iteration. Otherwise it is stale, so bring it up to date.
+         */
+        if (checkIteration && checkInterval > 1) {
+            copyProblem(problem, updatedProblem, problemDimension);
+        }
+
+        // startRowIndex is different for each process
+        relaxRows(
+            updatedProblem,
+            problemDimension,
+            startRowIndex,
+            rowsPerProcessor,
+            precision
+        );
 
         // Gather relaxed in all processors, into updatedProblem array
         error = MPI_Allgatherv(
             updatedProblem[startRowIndex], // start of data to send
-            rowsPerProcessor * problemDimension, // send this many doubles
-            MPI_DOUBLE,
+            1, // send one subarray (skips row padding)
+            context->subArrayType,
             updatedProblem[0], // receive into here
-            sendCounts,
-            displs,
-            subArrayType, // type received is our custom subarray type
-            running_comm
+            context->sendCounts,
+            context->displs,
+            context->subArrayType, // type received is our custom subarray type
+            context->running_comm
         );
 
         if (error) {
@@ -202,12 +783,1019 @@ int solve(
         }
 
         // Everyone updates their problem and checks if solved (for termination)
-        solved = updateProblem(problem, updatedProblem, problemDimension);
+        if (checkIteration) {
+            solved = updateProblem(problem, updatedProblem, problemDimension);
+        }
+
+        offerSnapshot(snapshotter, updatedProblem, ++*iteration);
     }
 
-    freeTwoDDoubleArray(updatedProblem);
+    return 0;
+}
+
+/**
+ * Relax the single precision problem in the given context to the given
+ * precision, until no value changes by stopPrecision or more. Partners the
+ * above iterate function, but works on (and exchanges rows of) single
+ * precision arrays, so moves half as much data.
+ *
+ * The single precision problem is either a copy of the problem itself, or
+ * (if given a residual) a correction to the double precision problem.
+ *
+ * @param  context       The context holding the problem to solve
+ * @param  residual      Four times the residual of the double precision
+ *                       problem, to relax a correction to it, or NULL to
+ *                       relax a copy of it
+ * @param  precision     The precision to relax values to
+ * @param  stopPrecision Stop once no value changes by this much or more
+ *                       between checks
+ * @param  checkInterval Check for convergence every checkInterval
+ *                       iterations
+ * @param  snapshotter   Snapshotter to offer the problem to after every
+ *                       iteration, NULL to take no snapshots
+ * @param  iteration     Number of iterations so far, updated as iterating
+ *
+ * @return               0 if success, error code otherwise
+ */
+static int iterateFloat(
+    SolveContext * const context,
+    float ** const residual,
+    const float precision,
+    const float stopPrecision,
+    const int checkInterval,
+    Snapshotter * const snapshotter,
+    int * const iteration
+)
+{
+    float ** const problem = context->floatProblem;
+    float ** const updatedProblem = context->floatUpdatedProblem;
+    const int problemDimension = context->problemDimension;
+    const int rowsPerProcessor = context->rowsPerProcessor;
+
+    // Initially set updatedProblem to be the same as problem
+    for (int row = 0; row < context->totalRows; row++) {
+        memcpy(
+            updatedProblem[row],
+            problem[row],
+            problemDimension * sizeof(float)
+        );
+    }
+
+    const int startRowIndex = context->rank * rowsPerProcessor;
+    int solved = 0;
+    int error;
+
+    while (!solved) {
+        const int checkIteration = (*iteration + 1) % checkInterval == 0;
+
+        if (checkIteration && checkInterval > 1) {
+            copyProblemFloat(problem, updatedProblem, problemDimension);
+        }
+
+        if (residual) {
+            relaxCorrectionRowsFloat(
+                updatedProblem,
+                residual,
+                problemDimension,
+                startRowIndex,
+                rowsPerProcessor,
+                precision
+            );
+        } else {
+            relaxRowsFloat(
+                updatedProblem,
+                problemDimension,
+                startRowIndex,
+                rowsPerProcessor,
+                precision
+            );
+        }
+
+        error = MPI_Allgatherv(
+            updatedProblem[startRowIndex],
+            1,
+            context->floatSubArrayType,
+            updatedProblem[0],
+            context->sendCounts,
+            context->displs,
+            context->floatSubArrayType,
+            context->running_comm
+        );
+
+        if (error) {
+            return error;
+        }
+
+        if (checkIteration) {
+            solved = updateProblemFloat(
+                problem,
+                updatedProblem,
+                problemDimension,
+                stopPrecision
+            );
+        }
+
+        if (residual) {
+            offerCorrectedSnapshot(
+                snapshotter,
+                context->problem,
+                updatedProblem,
+                ++*iteration
+            );
+        } else {
+            offerFloatSnapshot(snapshotter, updatedProblem, ++*iteration);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Create the single precision correction and residual arrays and datatype of
+ * the given context, if not already created.
+ *
+ * @param  context The context to create the single precision arrays of
+ *
+ * @return         0 if success, error code otherwise
+ */
+static int createFloatArrays(SolveContext * const context)
+{
+    if (context->floatSubArrayType != MPI_DATATYPE_NULL) {
+        return 0;
+    }
+
+    context->floatProblem = createTwoDFloatArray(
+        context->totalRows,
+        context->problemDimension
+    );
+    context->floatUpdatedProblem = createTwoDFloatArray(
+        context->totalRows,
+        context->problemDimension
+    );
+    context->floatResidual = createTwoDFloatArray(
+        context->totalRows,
+        context->problemDimension
+    );
+
+    if (!context->floatProblem || !context->floatUpdatedProblem
+        || !context->floatResidual) {
+        return -1;
+    }
+
+    return createRowsType(
+        context->totalRows,
+        context->problemDimension,
+        context->rowsPerProcessor,
+        twoDFloatArrayRowStride(context->problemDimension),
+        MPI_FLOAT,
+        sizeof(float),
+        &context->floatType,
+        &context->floatSubArrayType
+    );
+}
+
+/**
+ * Calculate the residual (the average of the neighbours of a value, less the
+ * value) of the calling processor's rows of the problem in the given context,
+ * in double precision, and store four times it in the single precision
+ * residual array (see relaxCorrectionRowsFloat).
+ *
+ * @param  context     The context holding the problem
+ * @param  maxResidual Set to the largest residual of any value
+ * @param  largest     Set to the largest magnitude of any value
+ *
+ * @return             0 if success, error code otherwise
+ */
+static int calculateResidual(
+    SolveContext * const context,
+    double * const maxResidual,
+    double * const largest
+)
+{
+    double ** const problem = context->problem;
+    float ** const residual = context->floatResidual;
+    const int problemDimension = context->problemDimension;
+    const int startRowIndex = context->rank * context->rowsPerProcessor;
+
+    int lastRow = startRowIndex + context->rowsPerProcessor;
+
+    if (lastRow > problemDimension) {
+        lastRow = problemDimension;
+    }
+
+    // Largest residual and largest value, reduced together
+    double maxima[2] = {0.0, 0.0};
+
+    for (int row = startRowIndex; row < lastRow; row++) {
+        for (int col = 0; col < problemDimension; col++) {
+            if (fabs(problem[row][col]) > maxima[1]) {
+                maxima[1] = fabs(problem[row][col]);
+            }
+
+            // Edges are fixed, so have no residual
+            if (row == 0 || row == problemDimension - 1
+                || col == 0 || col == problemDimension - 1) {
+
+                continue;
+            }
+
+            const double value = problem[row + 1][col] +
+                                 problem[row - 1][col] +
+                                 problem[row][col + 1] +
+                                 problem[row][col - 1] -
+                                 4 * problem[row][col];
+
+            residual[row][col] = value;
+
+            if (fabs(value) / 4 > maxima[0]) {
+                maxima[0] = fabs(value) / 4;
+            }
+        }
+    }
+
+    const int error = MPI_Allreduce(
+        MPI_IN_PLACE,
+        maxima,
+        2,
+        MPI_DOUBLE,
+        MPI_MAX,
+        context->running_comm
+    );
+
+    *maxResidual = maxima[0];
+    *largest = maxima[1];
+
+    return error;
+}
+
+/**
+ * Relax a single precision copy of the problem in the given context to the
+ * given precision, until no value changes by stopPrecision or more, and copy
+ * the interior back into the problem. The edges are fixed, so they keep
+ * their double precision values.
+ *
+ * @param  context       The context holding the problem to solve
+ * @param  precision     The precision to relax the copy to
+ * @param  stopPrecision Stop once no value changes by this much or more
+ *                       between checks
+ * @param  checkInterval Check for convergence every checkInterval
+ *                       iterations
+ * @param  snapshotter   Snapshotter to offer the problem to after every
+ *                       iteration, NULL to take no snapshots
+ * @param  iteration     Number of iterations so far, updated as iterating
+ *
+ * @return               0 if success, error code otherwise
+ */
+static int relaxFloatCopy(
+    SolveContext * const context,
+    const double precision,
+    const double stopPrecision,
+    const int checkInterval,
+    Snapshotter * const snapshotter,
+    int * const iteration
+)
+{
+    double ** const problem = context->problem;
+    float ** const floatProblem = context->floatProblem;
+    const int problemDimension = context->problemDimension;
+
+    for (int row = 0; row < problemDimension; row++) {
+        for (int col = 0; col < problemDimension; col++) {
+            floatProblem[row][col] = problem[row][col];
+        }
+    }
+
+    const int error = iterateFloat(
+        context,
+        NULL,
+        precision,
+        stopPrecision,
+        checkInterval,
+        snapshotter,
+        iteration
+    );
+
+    if (error) {
+        return error;
+    }
+
+    for (int row = 1; row < problemDimension - 1; row++) {
+        for (int col = 1; col < problemDimension - 1; col++) {
+            problem[row][col] = floatProblem[row][col];
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Solve the problem in the given context with single precision sweeps.
+ *
+ * First, while the residual is well above float rounding of the problem's
+ * values, a single precision copy of the problem itself is relaxed (see
+ * relaxFloatCopy) to the precision, until no value changes by the precision,
+ * or by the rounding error of the largest value, or more. Stopping there,
+ * rather than relaxing to the rounding error, leaves the small changes made
+ * as they would be in double precision, so refining afterwards takes no
+ * more sweeps than carrying on in double precision would.
+ *
+ * Then, while the residual (calculated in double precision) is not below
+ * the precision, it is removed by defect correction: the correction is
+ * relaxed in single precision (see relaxCorrectionRowsFloat) to the
+ * precision, and added to the problem in double precision. Float rounding
+ * is relative to the size of the correction, which is bounded by the
+ * residual times (dimension - 1)^2 / 2 (by the discrete maximum principle)
+ * and by twice the largest value. Rounding may leave a few values just over
+ * the precision, which a much shorter second correction removes. If the
+ * rounding error is over a quarter of the residual (on large problems
+ * solved to a tight precision) corrections would make little progress, and
+ * the solve is left for double precision to finish.
+ *
+ * @param  context       The context holding the problem to solve
+ * @param  precision     The precision to solve the problem to
+ * @param  checkInterval Check for convergence every checkInterval
+ *                       iterations
+ * @param  snapshotter   Snapshotter to offer the problem to after every
+ *                       iteration, NULL to take no snapshots
+ * @param  iteration     Number of iterations so far, updated as iterating
+ * @param  solved        Set to 1 if solved to the precision, 0 if it must be
+ *                       finished in double precision
+ *
+ * @return               0 if success, error code otherwise
+ */
+static int correctDefects(
+    SolveContext * const context,
+    const double precision,
+    const int checkInterval,
+    Snapshotter * const snapshotter,
+    int * const iteration,
+    int * const solved
+)
+{
+    double ** const problem = context->problem;
+    float ** const correction = context->floatProblem;
+    const int problemDimension = context->problemDimension;
+    const double span = (double)(problemDimension - 1) * (problemDimension - 1);
+    int copyRelaxed = 0;
+
+    *solved = 0;
+
+    for (;;) {
+        double maxResidual, largest;
+
+        int error = calculateResidual(context, &maxResidual, &largest);
+
+        if (error) {
+            return error;
+        }
+
+        // Same test as testSolution: one more pass would change nothing
+        if (maxResidual < precision) {
+            *solved = 1;
+
+            return 0;
+        }
+
+        const double valueRoundingError = FLOAT_ROUNDING_ULPS * FLT_EPSILON
+            * largest;
+
+        // A warm start may already be closer than float values can get
+        if (!copyRelaxed && valueRoundingError < maxResidual / 4) {
+            copyRelaxed = 1;
+
+            // Leave room for rounding, if it is small, to finish here
+            const double copyPrecision = precision > 8 * valueRoundingError
+                ? precision - valueRoundingError
+                : precision;
+
+            error = relaxFloatCopy(
+                context,
+                copyPrecision,
+                copyPrecision > valueRoundingError
+                    ? copyPrecision
+                    : valueRoundingError,
+                checkInterval,
+                snapshotter,
+                iteration
+            );
+
+            if (error) {
+                return error;
+            }
+
+            continue;
+        }
+
+        double bound = maxResidual * span / 2;
+
+        if (2 * largest < bound) {
+            bound = 2 * largest;
+        }
+
+        const double roundingError = FLOAT_ROUNDING_ULPS * FLT_EPSILON * bound;
+
+        // Float rounding would stop the correction making much progress
+        if (roundingError > maxResidual / 4) {
+            return 0;
+        }
+
+        // Rounding may leave a few values just over the precision, which the
+        // next (much smaller) correction removes
+        const double tolerance = precision > roundingError
+            ? precision
+            : roundingError;
+
+        for (int row = 0; row < context->totalRows; row++) {
+            memset(correction[row], 0, problemDimension * sizeof(float));
+        }
+
+        error = iterateFloat(
+            context,
+            context->floatResidual,
+            tolerance,
+            tolerance,
+            checkInterval,
+            snapshotter,
+            iteration
+        );
+
+        if (error) {
+            return error;
+        }
+
+        // Every processor holds the whole correction, so applies all of it
+        for (int row = 1; row < problemDimension - 1; row++) {
+            for (int col = 1; col < problemDimension - 1; col++) {
+                problem[row][col] += correction[row][col];
+            }
+        }
+    }
+}
+
+/**
+ * Solve the problem in the given context to the given precision in parallel.
+ * The problem array must be the same on every running processor, and will
+ * hold the solution on every running processor afterwards.
+ *
+ * In mixed precision, a single precision copy of the problem is relaxed,
+ * and refined by defect correction below the precision float rounding
+ * allows (see correctDefects), so every sweep is in single precision, and
+ * the rows exchanged each iteration are half the size. It takes a few
+ * percent more iterations, and single precision sweeps take as long as
+ * double precision ones, so it is only faster when exchanging rows is a
+ * large part of each iteration. If float rounding stops the corrections
+ * converging (on large problems solved to a tight precision), the solve is
+ * finished with double precision sweeps.
+ *
+ * Does nothing on processors that are not running.
+ *
+ * @param  context        The context holding the problem to solve
+ * @param  precision      The precision to solve the problem to
+ * @param  checkInterval  Check for convergence every checkInterval
+ *                        iterations. Checking less often saves a pass over
+ *                        the problem per iteration, but may run up to
+ *                        checkInterval - 1 iterations after convergence
+ * @param  mixedPrecision 1 to solve by defect correction, with sweeps in
+ *                        single precision, 0 to do all in double precision
+ * @param  snapshotter    Snapshotter to offer the problem to after every
+ *                        iteration, NULL to take no snapshots
+ *
+ * @return                0 if success, -1 if precision or checkInterval is
+ *                        not positive, error code otherwise
+ */
+int solveWithContext(
+    SolveContext * const context,
+    const double precision,
+    const int checkInterval,
+    const int mixedPrecision,
+    Snapshotter * const snapshotter
+)
+{
+    // A precision of 0 or less would never converge
+    if (precision <= 0 || checkInterval <= 0) {
+        return -1;
+    }
+
+    if (!context->running) {
+        return 0;
+    }
+
+    int iteration = 0;
+    int error;
+
+    context->iterations = 0;
+
+    if (mixedPrecision) {
+        error = createFloatArrays(context);
+
+        if (error) {
+            return error;
+        }
+
+        int solved;
+
+        error = correctDefects(
+            context,
+            precision,
+            checkInterval,
+            snapshotter,
+            &iteration,
+            &solved
+        );
+
+        if (error || solved) {
+            context->iterations = iteration;
+
+            return error;
+        }
+    }
+
+    error = iterate(context, precision, checkInterval, snapshotter, &iteration);
+
+    context->iterations = iteration;
+
+    return error;
+}
+
+/**
+ * Transpose a square matrix distributed by rows, so that each processor ends
+ * up with the same rows of the transpose.
+ *
+ * Each processor holds rowsPerProcessor rows of numProcessors *
+ * rowsPerProcessor values (the matrix padded with zeros). The rows are split
+ * into square blocks, one for each processor, which are swapped with a single
+ * MPI_Alltoall and transposed locally.
+ *
+ * @param  rows             The local rows to transpose, replaced by the
+ *                          local rows of the transpose
+ * @param  sendBuffer       Scratch buffer the same size as rows
+ * @param  receiveBuffer    Scratch buffer the same size as rows
+ * @param  rowsPerProcessor The rows each processor holds
+ * @param  numProcessors    The number of processors holding the matrix
+ * @param  running_comm     Communicator containing all processors holding the
+ *                          matrix
+ *
+ * @return                  0 if success, error code otherwise
+ */
+static int transposeRows(
+    double * const rows,
+    double * const sendBuffer,
+    double * const receiveBuffer,
+    const int rowsPerProcessor,
+    const int numProcessors,
+    MPI_Comm running_comm
+)
+{
+    const int b = rowsPerProcessor;
+    const int width = numProcessors * b;
+
+    // Block for processor q is columns q * b to (q + 1) * b of every row
+    for (int q = 0; q < numProcessors; q++) {
+        for (int row = 0; row < b; row++) {
+            memcpy(
+                &sendBuffer[(q * b + row) * b],
+                &rows[row * width + q * b],
+                b * sizeof(double)
+            );
+        }
+    }
+
+    const int error = MPI_Alltoall(
+        sendBuffer,
+        b * b,
+        MPI_DOUBLE,
+        receiveBuffer,
+        b * b,
+        MPI_DOUBLE,
+        running_comm
+    );
+
+    if (error) {
+        return error;
+    }
+
+    // Row r of the block from processor q becomes column q * b + r
+    for (int q = 0; q < numProcessors; q++) {
+        for (int row = 0; row < b; row++) {
+            for (int col = 0; col < b; col++) {
+                rows[col * width + q * b + row] =
+                    receiveBuffer[(q * b + row) * b + col];
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Take the DST of the first numRows local rows of a matrix distributed by
+ * rows. The remaining local rows are padding.
+ *
+ * @param plan    Plan for the length of the matrix rows
+ * @param rows    The local rows of the matrix
+ * @param numRows The number of local rows that are part of the matrix
+ * @param width   The number of values between the start of each row
+ */
+static void dstRows(
+    DstPlan * const plan,
+    double * const rows,
+    const int numRows,
+    const int width
+)
+{
+    // Two rows per FFT
+    for (int row = 0; row < numRows; row += 2) {
+        dstPair(
+            plan,
+            &rows[row * width],
+            row + 1 < numRows ? &rows[(row + 1) * width] : NULL
+        );
+    }
+}
+
+/**
+ * Solve the interior of the problem in the given context directly, writing it
+ * into target.
+ *
+ * The interior of the solution satisfies the discrete Laplace equation
+ * A u = b, where A is the five point stencil and b holds the edge values
+ * next to each interior point. With n = problemDimension - 2 interior rows
+ * and columns, A = T x I + I x T for the n x n second difference matrix T,
+ * which the DST diagonalises: S T = L S, with L the diagonal matrix of
+ * 2 - 2 cos(pi k / (n + 1)) and S S = (n + 1) / 2 I. So for U and B the
+ * interior and right hand side as matrices:
+ *
+ *     U = (2 / (n + 1))^2 S ((S B S) / (L_k + L_l)) S
+ *
+ * Each processor transforms its rows of the interior (using the existing
+ * decomposition, shifted down past the first edge row), and the matrix is
+ * transposed between processors twice, so the transforms along columns are
+ * also local.
+ *
+ * @param  context       The context holding the problem to solve
+ * @param  target        Array to write the interior of the solution into
+ * @param  rows          Zeroed buffer of numProcessors * rowsPerProcessor^2
+ *                       doubles, for the local rows
+ * @param  sendBuffer    Scratch buffer the same size as rows
+ * @param  receiveBuffer Scratch buffer the same size as rows
+ * @param  gathered      Buffer of numProcessors * rowsPerProcessor *
+ *                       (problemDimension - 2) doubles, for all rows
+ *
+ * @return               0 if success, error code otherwise
+ */
+static int directSolveInterior(
+    SolveContext * const context,
+    double ** const target,
+    double * const rows,
+    double * const sendBuffer,
+    double * const receiveBuffer,
+    double * const gathered
+)
+{
+    double ** const problem = context->problem;
+    const int n = context->problemDimension - 2;
+    const int numProcessors = context->numProcessors;
+    const int b = context->rowsPerProcessor;
+    const int width = numProcessors * b;
+    const int firstRow = context->rank * b;
+    const int localRows = firstRow >= n
+        ? 0
+        : (n - firstRow < b ? n - firstRow : b);
+
+    // Right hand side: edge values next to each interior point
+    for (int row = 0; row < localRows; row++) {
+        const int i = firstRow + row + 1;
+        double * const values = &rows[row * width];
+
+        for (int col = 0; col < n; col++) {
+            const int j = col + 1;
+
+            values[col] = (i == 1 ? problem[0][j] : 0)
+                + (i == n ? problem[n + 1][j] : 0)
+                + (j == 1 ? problem[i][0] : 0)
+                + (j == n ? problem[i][n + 1] : 0);
+        }
+    }
+
+    // B S, then transpose and (S B S)^T
+    dstRows(context->dstPlan, rows, localRows, width);
+
+    int error = transposeRows(
+        rows,
+        sendBuffer,
+        receiveBuffer,
+        b,
+        numProcessors,
+        context->running_comm
+    );
+
+    if (error) {
+        return error;
+    }
+
+    dstRows(context->dstPlan, rows, localRows, width);
+
+    // Divide by the eigenvalues of A (using gathered as scratch)
+    double * const eigenvalues = gathered;
+
+    for (int k = 0; k < n; k++) {
+        eigenvalues[k] = 2 - 2 * cos(PI * (k + 1) / (n + 1));
+    }
+
+    for (int row = 0; row < localRows; row++) {
+        const double rowEigenvalue = eigenvalues[firstRow + row];
+
+        for (int col = 0; col < n; col++) {
+            rows[row * width + col] /= rowEigenvalue + eigenvalues[col];
+        }
+    }
+
+    // Back again: (U S)^T, then transpose and S U S
+    dstRows(context->dstPlan, rows, localRows, width);
+
+    error = transposeRows(
+        rows,
+        sendBuffer,
+        receiveBuffer,
+        b,
+        numProcessors,
+        context->running_comm
+    );
+
+    if (error) {
+        return error;
+    }
+
+    dstRows(context->dstPlan, rows, localRows, width);
+
+    const double scale = (2.0 / (n + 1)) * (2.0 / (n + 1));
+
+    for (int row = 0; row < b; row++) {
+        for (int col = 0; col < n; col++) {
+            sendBuffer[row * n + col] = rows[row * width + col] * scale;
+        }
+    }
 
-    MPI_Type_free(&subArrayType);
+    // Everyone holds the whole problem, so share the solved rows
+    error = MPI_Allgather(
+        sendBuffer,
+        b * n,
+        MPI_DOUBLE,
+        gathered,
+        b * n,
+        MPI_DOUBLE,
+        context->running_comm
+    );
+
+    if (error) {
+        return error;
+    }
+
+    for (int row = 0; row < n; row++) {
+        memcpy(&target[row + 1][1], &gathered[row * n], n * sizeof(double));
+    }
+
+    return 0;
+}
+
+/**
+ * Create the DST plan and buffers of the given context used by direct
+ * solves, if not already created. They are kept in the context, so only the
+ * first direct solve allocates them.
+ *
+ * @param  context The context to create the direct solve buffers of
+ *
+ * @return         0 if success, -1 otherwise
+ */
+static int createDirectBuffers(SolveContext * const context)
+{
+    const int n = context->problemDimension - 2;
+    const size_t localSize = (size_t)context->rowsPerProcessor
+        * context->rowsPerProcessor * context->numProcessors;
+
+    if (!context->dstPlan) {
+        context->dstPlan = createDstPlan(n);
+    }
+
+    if (!context->directRows) {
+        context->directRows = createOneDDoubleArray(localSize);
+    }
+
+    if (!context->directSendBuffer) {
+        context->directSendBuffer = createOneDDoubleArray(localSize);
+    }
+
+    if (!context->directReceiveBuffer) {
+        context->directReceiveBuffer = createOneDDoubleArray(localSize);
+    }
+
+    if (!context->directGathered) {
+        context->directGathered = createOneDDoubleArray(
+            (size_t)context->rowsPerProcessor * context->numProcessors * n
+        );
+    }
+
+    if (!context->dstPlan || !context->directRows
+        || !context->directSendBuffer || !context->directReceiveBuffer
+        || !context->directGathered) {
+
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Solve the problem in the given context directly, writing the solution
+ * (including the fixed edges) into target.
+ *
+ * @param  context The context holding the problem to solve
+ * @param  target  Array to write the solution into (may be the problem)
+ *
+ * @return         0 if success, error code otherwise
+ */
+static int directSolve(SolveContext * const context, double ** const target)
+{
+    double ** const problem = context->problem;
+    const int problemDimension = context->problemDimension;
+    const int n = problemDimension - 2;
+
+    // Edges are fixed
+    if (target != problem) {
+        for (int row = 0; row < problemDimension; row++) {
+            if (row == 0 || row == problemDimension - 1) {
+                memcpy(
+                    target[row],
+                    problem[row],
+                    problemDimension * sizeof(double)
+                );
+            } else {
+                target[row][0] = problem[row][0];
+                target[row][problemDimension - 1] =
+                    problem[row][problemDimension - 1];
+            }
+        }
+    }
+
+    // No interior to solve
+    if (n <= 0) {
+        return 0;
+    }
+
+    if (createDirectBuffers(context)) {
+        return -1;
+    }
+
+    const size_t localSize = (size_t)context->rowsPerProcessor
+        * context->rowsPerProcessor * context->numProcessors;
+
+    // Padding must be zero; the last solve left its transforms in rows
+    memset(context->directRows, 0, localSize * sizeof(double));
+
+    return directSolveInterior(
+        context,
+        target,
+        context->directRows,
+        context->directSendBuffer,
+        context->directReceiveBuffer,
+        context->directGathered
+    );
+}
+
+/**
+ * Solve the problem in the given context directly, with discrete sine
+ * transforms rather than iterating. Only the edges of the problem are used.
+ * The problem array will hold the exact solution of the discrete problem on
+ * every running processor afterwards.
+ *
+ * Does nothing on processors that are not running.
+ *
+ * @param  context The context holding the problem to solve
+ *
+ * @return         0 if success, error code otherwise
+ */
+int solveDirectWithContext(SolveContext * const context)
+{
+    if (!context->running) {
+        return 0;
+    }
+
+    return directSolve(context, context->problem);
+}
+
+/**
+ * Compare the problem in the given context (e.g. an iterative solution) with
+ * the direct solution of a problem with the same edges.
+ *
+ * Does nothing on processors that are not running.
+ *
+ * @param  context       The context holding the solution to check
+ * @param  maxDifference Set to the largest difference between any value of
+ *                       the problem and of the direct solution
+ *
+ * @return               0 if success, error code otherwise
+ */
+int directSolutionDifference(
+    SolveContext * const context,
+    double * const maxDifference
+)
+{
+    *maxDifference = 0.0;
+
+    if (!context->running) {
+        return 0;
+    }
+
+    // updatedProblem is only scratch between solves
+    const int error = directSolve(context, context->updatedProblem);
+
+    if (error) {
+        return error;
+    }
+
+    for (int row = 0; row < context->problemDimension; row++) {
+        for (int col = 0; col < context->problemDimension; col++) {
+            const double difference = fabs(
+                context->problem[row][col] - context->updatedProblem[row][col]
+            );
+
+            if (difference > *maxDifference) {
+                *maxDifference = difference;
+            }
+        }
+    }
 
     return 0;
 }
+
+/**
+ * Frees a given solve context, including its problem arrays, communicator
+ * and datatypes. Must be called by every processor that created it.
+ *
+ * @param context The context to free
+ */
+void freeSolveContext(SolveContext * const context)
+{
+    if (context->problem) {
+        freeTwoDDoubleArray(context->problem);
+    }
+
+    if (context->updatedProblem) {
+        freeTwoDDoubleArray(context->updatedProblem);
+    }
+
+    if (context->subArrayType != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&context->subArrayType);
+    }
+
+    if (context->type != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&context->type);
+    }
+
+    if (context->floatProblem) {
+        freeTwoDFloatArray(context->floatProblem);
+    }
+
+    if (context->floatUpdatedProblem) {
+        freeTwoDFloatArray(context->floatUpdatedProblem);
+    }
+
+    if (context->floatResidual) {
+        freeTwoDFloatArray(context->floatResidual);
+    }
+
+    if (context->floatSubArrayType != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&context->floatSubArrayType);
+    }
+
+    if (context->floatType != MPI_DATATYPE_NULL) {
+        MPI_Type_free(&context->floatType);
+    }
+
+    if (context->directRows) {
+        freeOneDDoubleArray(context->directRows);
+    }
+
+    if (context->directSendBuffer) {
+        freeOneDDoubleArray(context->directSendBuffer);
+    }
+
+    if (context->directReceiveBuffer) {
+        freeOneDDoubleArray(context->directReceiveBuffer);
+    }
+
+    if (context->directGathered) {
+        freeOneDDoubleArray(context->directGathered);
+    }
+
+    if (context->dstPlan) {
+        freeDstPlan(context->dstPlan);
+    }
+
+    free(context->displs);
+    free(context->sendCounts);
+
+    MPI_Comm_free(&context->running_comm);
+
+    free(context);
+}
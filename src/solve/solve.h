@@ -1,28 +1,119 @@
+#ifndef SOLVE_H
+#define SOLVE_H
+
+#include <mpi.h>
+
+#include "../snapshot/snapshot.h"
+#include "export.h"
+
 /**
- * Solve the given problem to the given precision in parallel, using the given
- * number of processors.
- *
- * @param  problem          The problem to solve (including padding rows)
- * @param  problemRows      The rows of the given problem array that are part of
- *                          the problem
- * @param  totalRows        The total rows of the given problem array
- * @param  precision        The precision to solve the problem to
- * @param  numProcessors    The number of processors being used to solve the
- *                          problem
- * @param  rowsPerProcessor The rows each processor should relax
- * @param  rank             The rank of the calling processor
- * @param  running_comm     Communicator containing all processes that are
- *                          running this function
- *
- * @return                  0 if success, error code otherwise
- */
-int solve(
-    double ** const problem,
-    const int problemRows,
-    const int totalRows,
+ * Persistent state for solving a sequence of problems of the same dimension.
+ */
+typedef struct SolveContext SolveContext;
+
+/**
+ * Create a context for solving problems of the given dimension in parallel.
+ * Must be called by every processor in comm.
+ *
+ * @param  problemDimension Dimension of problems to be solved
+ * @param  useProcessors    Maximum number of processors in comm to use
+ * @param  comm             Communicator containing all processes that may
+ *                          take part in solving
+ *
+ * @return                  Pointer to the created context, NULL if it could
+ *                          not be created (or problemDimension or
+ *                          useProcessors is not positive)
+ */
+LIBSOLVE_API SolveContext *createSolveContext(
+    const int problemDimension,
+    const int useProcessors,
+    MPI_Comm comm
+);
+
+/**
+ * Checks if the calling processor takes part in solving with this context.
+ *
+ * @param  context The context to check
+ *
+ * @return         1 if running, 0 otherwise
+ */
+LIBSOLVE_API int solveContextRunning(const SolveContext * const context);
+
+/**
+ * Get the problem array of this context (including padding rows). Holds the
+ * last solution between solves, so the next solve warm starts from it.
+ *
+ * @param  context The context to get the problem array of
+ *
+ * @return         The problem array, NULL if this processor is not running
+ */
+LIBSOLVE_API double **solveContextProblem(
+    const SolveContext * const context
+);
+
+/**
+ * Get the number of iterations the last solve with this context took.
+ *
+ * @param  context The context to get the iterations of
+ *
+ * @return         Number of iterations, 0 if not solved yet
+ */
+LIBSOLVE_API int solveContextIterations(const SolveContext * const context);
+
+/**
+ * Solve the problem in the given context to the given precision in parallel.
+ *
+ * @param  context        The context holding the problem to solve
+ * @param  precision      The precision to solve the problem to
+ * @param  checkInterval  Check for convergence every checkInterval
+ *                        iterations
+ * @param  mixedPrecision 1 to solve by defect correction, with sweeps in
+ *                        single precision, 0 to do all in double precision
+ * @param  snapshotter    Snapshotter to offer the problem to after every
+ *                        iteration, NULL to take no snapshots
+ *
+ * @return                0 if success, -1 if precision or checkInterval is
+ *                        not positive, error code otherwise
+ */
+LIBSOLVE_API int solveWithContext(
+    SolveContext * const context,
     const double precision,
-    const int numProcessors,
-    const int rowsPerProcessor,
-    const int rank,
-    MPI_Comm running_comm
+    const int checkInterval,
+    const int mixedPrecision,
+    Snapshotter * const snapshotter
 );
+
+/**
+ * Solve the problem in the given context directly, with discrete sine
+ * transforms rather than iterating. Only the edges of the problem are used.
+ *
+ * @param  context The context holding the problem to solve
+ *
+ * @return         0 if success, error code otherwise
+ */
+LIBSOLVE_API int solveDirectWithContext(SolveContext * const context);
+
+/**
+ * Compare the problem in the given context (e.g. an iterative solution) with
+ * the direct solution of a problem with the same edges.
+ *
+ * @param  context       The context holding the solution to check
+ * @param  maxDifference Set to the largest difference between any value of
+ *                       the problem and of the direct solution
+ *
+ * @return               0 if success, error code otherwise
+ */
+LIBSOLVE_API int directSolutionDifference(
+    SolveContext * const context,
+    double * const maxDifference
+);
+
+/**
+ * Frees a given solve context. Must be called by every processor that
+ * created it.
+ *
+ * @param context The context to free
+ */
+LIBSOLVE_API void freeSolveContext(SolveContext * const context);
+
+#endif
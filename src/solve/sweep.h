@@ -0,0 +1,21 @@
+#ifndef SOLVE_SWEEP_H
+#define SOLVE_SWEEP_H
+
+/**
+ * Measure how long relaxing, and checking for convergence, take per point
+ * of a problem of the given dimension on the calling processor.
+ *
+ * @param  problemDimension The dimension of problem to time
+ * @param  relaxTime        Set to the seconds taken to relax one point
+ * @param  updateTime       Set to the seconds taken to check and update one
+ *                          point
+ *
+ * @return                  0 if success, error code otherwise
+ */
+int measureSweepTimes(
+    const int problemDimension,
+    double * const relaxTime,
+    double * const updateTime
+);
+
+#endif
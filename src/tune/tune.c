@@ -0,0 +1,367 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <mpi.h>
+
+#include "../solve/sweep.h"
+
+/**
+ * File that tuning decisions are cached in, one per line as:
+ * problemDimension precision maxProcessors numProcessors checkInterval
+ */
+#define TUNING_FILE "./output/tuning.txt"
+
+/**
+ * Largest check interval the autotuner will choose.
+ */
+#define MAX_CHECK_INTERVAL 64
+
+/**
+ * Number of doubles each processor contributes when measuring bandwidth.
+ */
+#define BANDWIDTH_DOUBLES 32768
+
+/**
+ * Number of repeats to average each message timing over.
+ */
+#define MESSAGE_REPEATS 10
+
+/**
+ * Iterations per squared problem dimension for relaxation to converge by a
+ * factor of e, fitted to measured iterations (see estimateIterations).
+ */
+#define CONVERGENCE_SCALE 0.1
+
+/**
+ * Look up a cached tuning decision for the given problem.
+ *
+ * @param  problemDimension Dimension of problem to be solved
+ * @param  precision        Precision to solve to
+ * @param  maxProcessors    Number of processors available
+ * @param  numProcessors    Set to the cached number of processors to use
+ * @param  checkInterval    Set to the cached convergence check interval
+ *
+ * @return                  1 if a decision was found, 0 otherwise
+ */
+static int readCachedDecision(
+    const int problemDimension,
+    const double precision,
+    const int maxProcessors,
+    int * const numProcessors,
+    int * const checkInterval
+)
+{
+    FILE * const f = fopen(TUNING_FILE, "r");
+
+    if (!f) {
+        return 0;
+    }
+
+    int dimension, processors, useProcessors, interval;
+    double tunedPrecision;
+    int found = 0;
+
+    while (fscanf(
+        f,
+        "%d %lf %d %d %d",
+        &dimension,
+        &tunedPrecision,
+        &processors,
+        &useProcessors,
+        &interval
+    ) == 5) {
+        if (dimension == problemDimension
+            && tunedPrecision == precision
+            && processors == maxProcessors) {
+
+            // Keep going, so the most recent decision wins
+            *numProcessors = useProcessors;
+            *checkInterval = interval;
+            found = 1;
+        }
+    }
+
+    fclose(f);
+
+    return found;
+}
+
+/**
+ * Append a tuning decision to the cache.
+ *
+ * @param problemDimension Dimension of problem to be solved
+ * @param precision        Precision to solve to
+ * @param maxProcessors    Number of processors available
+ * @param numProcessors    Number of processors to use
+ * @param checkInterval    Convergence check interval to use
+ */
+static void writeCachedDecision(
+    const int problemDimension,
+    const double precision,
+    const int maxProcessors,
+    const int numProcessors,
+    const int checkInterval
+)
+{
+    FILE * const f = fopen(TUNING_FILE, "a");
+
+    if (!f) {
+        return;
+    }
+
+    fprintf(
+        f,
+        "%d %.17g %d %d %d\n",
+        problemDimension,
+        precision,
+        maxProcessors,
+        numProcessors,
+        checkInterval
+    );
+
+    fclose(f);
+}
+
+/**
+ * Time an MPI_Allgather of the given number of doubles per processor across
+ * all processors.
+ *
+ * @param  count  Number of doubles each processor contributes
+ * @param  buffer Buffer of at least count * number of processors doubles
+ *
+ * @return        Seconds taken by the slowest processor, averaged over
+ *                MESSAGE_REPEATS gathers
+ */
+static double timeAllgather(const int count, double * const buffer)
+{
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    const double start = MPI_Wtime();
+
+    for (int i = 0; i < MESSAGE_REPEATS; i++) {
+        MPI_Allgather(
+            MPI_IN_PLACE,
+            0,
+            MPI_DATATYPE_NULL,
+            buffer,
+            count,
+            MPI_DOUBLE,
+            MPI_COMM_WORLD
+        );
+    }
+
+    double elapsed = (MPI_Wtime() - start) / MESSAGE_REPEATS;
+
+    MPI_Allreduce(MPI_IN_PLACE, &elapsed, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+
+    return elapsed;
+}
+
+/**
+ * Estimate how many iterations solve will take, as
+ *
+ *     scale * ln(1 + 4 / (scale * precision)), scale = 0.1 * dimension^2
+ *
+ * Values stop being updated once they change by less than the precision, so
+ * at loose precisions this is close to 4 / precision. At tight precisions
+ * the slow convergence of relaxation dominates, and each tenfold tighter
+ * precision takes about 0.23 * dimension^2 more iterations. This matches
+ * measured iterations to within about 25% for dimensions 25-400 and
+ * precisions 0.1-1e-5 (and down to 1e-10 for dimension 100), e.g. 2064
+ * measured and 1609 estimated for dimension 100 at precision 1e-3.
+ *
+ * @param  problemDimension Dimension of problem to be solved
+ * @param  precision        Precision to solve to
+ *
+ * @return                  Estimated number of iterations
+ */
+static double estimateIterations(
+    const int problemDimension,
+    const double precision
+)
+{
+    const double scale = CONVERGENCE_SCALE
+        * problemDimension * problemDimension;
+
+    const double iterations = scale * log(1.0 + 4.0 / (scale * precision));
+
+    return iterations < 1.0 ? 1.0 : iterations;
+}
+
+/**
+ * Choose the number of processors to use, and how often to check for
+ * convergence, for the given problem.
+ *
+ * Decisions are cached in TUNING_FILE. If there is no cached decision, all
+ * processors calibrate a cost model together: the time to relax and check a
+ * point is measured on each processor, and the latency and bandwidth of an
+ * MPI_Allgather (which solve does every iteration) are measured across all
+ * processors. The model then picks the number of processors (and so rows per
+ * processor) with the cheapest iteration, and the check interval that best
+ * trades fewer convergence checks against overrunning convergence.
+ *
+ * Must be called by every processor in MPI_COMM_WORLD.
+ *
+ * @param  problemDimension Dimension of problem to be solved
+ * @param  precision        Precision to solve to
+ * @param  maxProcessors    Number of processors available
+ * @param  rank             Rank of processor calling this function
+ * @param  numProcessors    Set to the number of processors to use
+ * @param  checkInterval    Set to the convergence check interval to use
+ *
+ * @return                  0 if success, error code otherwise
+ */
+int autotune(
+    const int problemDimension,
+    const double precision,
+    const int maxProcessors,
+    const int rank,
+    int * const numProcessors,
+    int * const checkInterval
+)
+{
+    int decision[3] = {0, maxProcessors, 1};
+
+    if (rank == 0) {
+        decision[0] = readCachedDecision(
+            problemDimension,
+            precision,
+            maxProcessors,
+            &decision[1],
+            &decision[2]
+        );
+    }
+
+    int error = MPI_Bcast(decision, 3, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (error) {
+        return error;
+    }
+
+    if (decision[0]) {
+        *numProcessors = decision[1];
+        *checkInterval = decision[2];
+
+        return 0;
+    }
+
+    // Measure stencil throughput; the slowest processor sets the pace
+    double sweepTimes[2];
+
+    error = measureSweepTimes(problemDimension, &sweepTimes[0], &sweepTimes[1]);
+
+    if (error) {
+        return error;
+    }
+
+    MPI_Allreduce(
+        MPI_IN_PLACE,
+        sweepTimes,
+        2,
+        MPI_DOUBLE,
+        MPI_MAX,
+        MPI_COMM_WORLD
+    );
+
+    const double relaxTime = sweepTimes[0];
+    const double updateTime = sweepTimes[1];
+
+    // Measure message latency and bandwidth
+    double latency = 0.0;
+    double byteTime = 0.0;
+
+    if (maxProcessors > 1) {
+        double * const buffer = (double *)calloc(
+            (size_t)BANDWIDTH_DOUBLES * maxProcessors,
+            sizeof(double)
+        );
+
+        if (!buffer) {
+            return -1;
+        }
+
+        const double smallTime = timeAllgather(1, buffer);
+        const double largeTime = timeAllgather(BANDWIDTH_DOUBLES, buffer);
+
+        free(buffer);
+
+        // Ring allgather: (p - 1) steps, each moving one processor's data
+        latency = smallTime / (maxProcessors - 1);
+        byteTime = (largeTime - smallTime)
+            / ((maxProcessors - 1) * (double)BANDWIDTH_DOUBLES * sizeof(double));
+
+        if (byteTime < 0.0) {
+            byteTime = 0.0;
+        }
+    }
+
+    const double points = (double)problemDimension * problemDimension;
+
+    // Pick the processor count with the cheapest iteration
+    int bestProcessors = 1;
+    double bestIterationTime = 0.0;
+
+    for (int p = 1; p <= maxProcessors && p <= problemDimension; p++) {
+        // Same decomposition as runSolve: pad rows to a multiple of p
+        const int rowsPerProcessor = (problemDimension + p - 1) / p;
+        const int active = (problemDimension + rowsPerProcessor - 1)
+            / rowsPerProcessor;
+
+        if (active != p) {
+            // Same as a smaller processor count, which was already considered
+            continue;
+        }
+
+        double iterationTime = rowsPerProcessor * problemDimension * relaxTime;
+
+        if (active > 1) {
+            const double gatheredBytes = (double)rowsPerProcessor * active
+                * problemDimension * sizeof(double);
+
+            iterationTime += latency * (active - 1)
+                + byteTime * gatheredBytes * (active - 1) / active;
+        }
+
+        if (p == 1 || iterationTime < bestIterationTime) {
+            bestProcessors = p;
+            bestIterationTime = iterationTime;
+        }
+    }
+
+    /*
+     * Pick the check interval. Checking every iteration costs one pass over
+     * the problem per iteration. Checking every k > 1 iterations costs two
+     * passes (copy, then check) every k iterations, but on average overruns
+     * convergence by (k - 1) / 2 iterations.
+     */
+    const double iterations = estimateIterations(problemDimension, precision);
+    const double checkTime = points * updateTime;
+
+    int bestInterval = 1;
+    double bestTotal = iterations * checkTime;
+
+    for (int k = 2; k <= MAX_CHECK_INTERVAL; k++) {
+        const double total = iterations * 2 * checkTime / k
+            + (k - 1) / 2.0 * (bestIterationTime + 2 * checkTime / k);
+
+        if (total < bestTotal) {
+            bestInterval = k;
+            bestTotal = total;
+        }
+    }
+
+    *numProcessors = bestProcessors;
+    *checkInterval = bestInterval;
+
+    if (rank == 0) {
+        writeCachedDecision(
+            problemDimension,
+            precision,
+            maxProcessors,
+            bestProcessors,
+            bestInterval
+        );
+    }
+
+    return 0;
+}
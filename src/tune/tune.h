@@ -0,0 +1,24 @@
+/**
+ * Choose the number of processors to use, and how often to check for
+ * convergence, for the given problem. Decisions are cached, so only the first
+ * run for a given problem calibrates.
+ *
+ * Must be called by every processor in MPI_COMM_WORLD.
+ *
+ * @param  problemDimension Dimension of problem to be solved
+ * @param  precision        Precision to solve to
+ * @param  maxProcessors    Number of processors available
+ * @param  rank             Rank of processor calling this function
+ * @param  numProcessors    Set to the number of processors to use
+ * @param  checkInterval    Set to the convergence check interval to use
+ *
+ * @return                  0 if success, error code otherwise
+ */
+int autotune(
+    const int problemDimension,
+    const double precision,
+    const int maxProcessors,
+    const int rank,
+    int * const numProcessors,
+    int * const checkInterval
+);